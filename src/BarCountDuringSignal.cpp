@@ -2,6 +2,8 @@
 
    This study counts the number of bars while the given subgraph value is non-zero.
    The subgraph produced by this study contains the count.
+   The signal can also be an expression over up to four subgraphs, such as A > B && C != 0.
+   See SignalExpression.h.
    
    MIT License
    
@@ -27,20 +29,22 @@
 */
 
 #include "sierrachart.h"
+#include "SignalInputs.h"
+#include "StudyKernels.h"
 SCDLLName("Bar Count During Signal Study")
 
+const SignalInputIndexes SIGNAL_INPUTS = { { 0, 2, 3, 4 }, 1 };
+
 SCSFExport scsf_TemplateFunction(SCStudyInterfaceRef sc) {
     SCSubgraphRef count = sc.Subgraph[0];
-    SCInputRef signalInput = sc.Input[0];
-    SCFloatArray signal;
+    SCFloatArray operands[SIGNAL_OPERAND_COUNT];
 
 	if(sc.SetDefaults) {
 		sc.GraphName = "Bar Count During Signal Study";
-        sc.StudyDescription = "This study counts the number of bars while the given subgraph value is non-zero. The subgraph produced by this study contains the count.";
+        sc.StudyDescription = "This study counts the number of bars while the given subgraph value is non-zero. The subgraph produced by this study contains the count. The signal can also be an expression over up to four subgraphs, such as A > B && C != 0.";
 		sc.AutoLoop = 1;
         
-        signalInput.Name = "Subgraph to use as the signal to count.";
-        signalInput.SetChartStudySubgraphValues(1,1, 0);
+        SetSignalInputDefaults(sc, SIGNAL_INPUTS);
 
 		count.Name = "Count";
 		count.DrawStyle = DRAWSTYLE_LINE;
@@ -50,9 +54,16 @@ SCSFExport scsf_TemplateFunction(SCStudyInterfaceRef sc) {
 		return;
 	}
 
-    sc.GetStudyArrayFromChartUsingID(signalInput.GetChartStudySubgraphValues(), signal);
-
-    if(signal[sc.Index] != 0) {
-        count[sc.Index] = count[sc.Index - 1] + 1;
+    if(sc.LastCallToFunction) {
+        ReleaseSignalProgram(sc, 0);
+        return;
     }
+
+    const SignalProgram& program = GetSignalProgram(sc, SIGNAL_INPUTS, 0);
+    GetSignalOperands(sc, SIGNAL_INPUTS, program, operands);
+
+    const BarCountDuringSignalKernel barCount;
+    const float priorCount = sc.Index > 0 ? count[sc.Index - 1] : 0;
+
+    count[sc.Index] = barCount(priorCount, EvaluateSignalAt(program, operands, sc.Index));
 }
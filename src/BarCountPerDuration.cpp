@@ -3,6 +3,11 @@
    This study counts the number of bars within the given duration.
    The duration can be provided in hours, minutes, or seconds.
 
+   Optionally, the study keeps a time-of-day activity profile: the mean and variance of the bar count
+   for each minute of the day, over about the last N sessions. The profile is updated once per minute,
+   saved between sessions (see StudyCheckpoint.h), and used to output the expected bar count,
+   and the z-score of the current bar count against it.
+
    MIT License
    
    Copyright (c) 2024 Emmanuel Rosa
@@ -27,45 +32,231 @@
 */
 
 #include "sierrachart.h"
+#include "StudyCheckpoint.h"
+#include "StudyKernels.h"
 SCDLLName("Bar Count per Duration")
 
 const SCString DURATION_UNIT_OPTIONS = "Hours;Minutes;Seconds";
 const unsigned int MAX_DURATION = INT_MAX;
+const int MINUTES_PER_DAY = 1440;
+const int PROFILE_CHECKPOINT_VERSION = 1;
 
-enum DurationUnitEnum {
-    DURATION_HOURS
-    , DURATION_MINUTES
-    , DURATION_SECONDS
+enum SubgraphIndexEnum {
+    BAR_COUNT_SUBGRAPH
+    , Z_SCORE_SUBGRAPH
+    , EXPECTED_BAR_COUNT_SUBGRAPH
 };
 
 enum InputIndexEnum {
     DURATION_UNIT_INPUT
     , DURATION_VALUE_INPUT
+    , PROFILE_ENABLED_INPUT
+    , PROFILE_SESSIONS_INPUT
 };
 
 enum PersistentVariableIndexEnum {
     END_DATE_TIME_VARIABLE
     , START_TIME_BAR_INDEX_VARIABLE
+    , PROFILE_LAST_INDEX_VARIABLE
+};
+
+enum PersistentPointerIndexEnum {
+    PROFILE_POINTER
+};
+
+/* The bar count statistics for each minute of the day.
+ * This is the checkpoint's payload, so it must stay plain data.
+ */
+struct ActivityProfile {
+    int sampleCount[MINUTES_PER_DAY];
+    double mean[MINUTES_PER_DAY];
+    double variance[MINUTES_PER_DAY];
+};
+
+struct ActivityProfileState {
+    StudyFingerprint fingerprint;
+    SCDateTime lastUpdateDateTime; // Bars up to this date-time are already in the profile.
+    ActivityProfile profile;
+    SCDateTime loadedDateTime; // The lastUpdateDateTime of the profile as it was loaded from disk.
+    ActivityProfile loadedProfile; // The profile as it was loaded from disk, which each recalculation restarts from.
+};
+
+// Lets the kernels in StudyKernels.h create SCDateTime durations.
+struct SCDateTimeTraits {
+    typedef SCDateTime Type;
+
+    static SCDateTime Hours(unsigned int value) { return SCDateTime::HOURS(value); }
+    static SCDateTime Minutes(unsigned int value) { return SCDateTime::MINUTES(value); }
+    static SCDateTime Seconds(unsigned int value) { return SCDateTime::SECONDS(value); }
 };
 
-SCDateTime GetDuration(DurationUnitEnum durationUnit, unsigned int duration) {
-    if(durationUnit == DURATION_HOURS) return SCDateTime::HOURS(duration);
-    if(durationUnit == DURATION_MINUTES) return SCDateTime::MINUTES(duration);
+/* Adds one session's bar count for the given minute.
+ * For the first N sessions this is Welford's update. After that, each new session is given a weight of 1/N,
+ * so that the profile follows roughly the last N sessions, while still costing O(1) per update.
+ */
+void UpdateActivityProfile(ActivityProfile& profile, int minute, double barCount, int sessions) {
+    int& n = profile.sampleCount[minute];
+    double& mean = profile.mean[minute];
+    double& variance = profile.variance[minute];
+
+    // Lowering the number of sessions takes effect right away, rather than only once n catches up.
+    n = min(n + 1, sessions);
+
+    const double weight = 1.0 / n;
+    const double delta = barCount - mean;
+
+    mean += weight * delta;
+    variance = (1.0 - weight) * (variance + weight * delta * delta);
+}
+
+StudyFingerprint ActivityProfileFingerprint(SCStudyInterfaceRef sc) {
+    StudyFingerprint fingerprint = BeginStudyFingerprint(sc, PROFILE_CHECKPOINT_VERSION);
+
+    fingerprint.Add(sc.Input[DURATION_UNIT_INPUT].GetIndex()).Add(sc.Input[DURATION_VALUE_INPUT].GetInt());
+    return fingerprint;
+}
+
+void SaveActivityProfile(SCStudyInterfaceRef sc, const ActivityProfileState& state) {
+    if(!WriteStudyCheckpoint(sc, StudyCheckpointPath(sc, "activity-profile"), state.fingerprint, state.lastUpdateDateTime, &state.profile, sizeof(state.profile))) {
+        sc.AddMessageToLog("ERROR: Unable to save the activity profile.", 1);
+    }
+}
+
+/* Prepares the profile for a full recalculation.
+ * The profile is only read from disk on the first calculation, or when the inputs it depends on change.
+ * Otherwise the recalculation restarts from the profile as it was loaded, rather than from the one built since,
+ * so that only the bars covered by the checkpoint on disk are treated as already in the profile.
+ * Any bars already in the loaded profile are skipped as the chart recalculates, so they're never counted twice.
+ */
+ActivityProfileState& LoadActivityProfile(SCStudyInterfaceRef sc) {
+    void*& pointer = sc.GetPersistentPointer(PROFILE_POINTER);
+    const StudyFingerprint fingerprint = ActivityProfileFingerprint(sc);
+    bool load = false;
+
+    if(pointer == NULL) {
+        pointer = new ActivityProfileState();
+        load = true;
+    } else if(static_cast<ActivityProfileState*>(pointer)->fingerprint.Value() != fingerprint.Value()) {
+        // Keep the profile of the old inputs, before switching.
+        SaveActivityProfile(sc, *static_cast<ActivityProfileState*>(pointer));
+        load = true;
+    }
+
+    ActivityProfileState& state = *static_cast<ActivityProfileState*>(pointer);
+
+    if(load) {
+        state.fingerprint = fingerprint;
+
+        if(!ReadStudyCheckpointFile(sc, StudyCheckpointPath(sc, "activity-profile"), state.fingerprint, state.loadedDateTime, &state.loadedProfile, sizeof(state.loadedProfile))) {
+            memset(&state.loadedProfile, 0, sizeof(state.loadedProfile));
+            state.loadedDateTime = SCDateTime();
+        }
+    }
+
+    state.profile = state.loadedProfile;
+    state.lastUpdateDateTime = state.loadedDateTime;
+    return state;
+}
+
+void ReleaseActivityProfile(SCStudyInterfaceRef sc) {
+    void*& pointer = sc.GetPersistentPointer(PROFILE_POINTER);
+
+    if(pointer != NULL) {
+        ActivityProfileState* state = static_cast<ActivityProfileState*>(pointer);
+
+        SaveActivityProfile(sc, *state);
+        delete state;
+        pointer = NULL;
+    }
+}
+
+int MinuteOfDay(const SCDateTime& dateTime) {
+    return dateTime.GetTimeInSeconds() / 60;
+}
+
+void UpdateActivityProfileAt(SCStudyInterfaceRef sc, ActivityProfileState& state, int index) {
+    SCSubgraphRef barCountSubgraph = sc.Subgraph[BAR_COUNT_SUBGRAPH];
+    int& profileLastIndex = sc.GetPersistentInt(PROFILE_LAST_INDEX_VARIABLE);
+    ActivityProfile& profile = state.profile;
+
+    /* When a new bar opens, the prior bar is final. If it was the last bar of its minute,
+     * its bar count is this session's sample for that minute.
+     */
+    if(index != profileLastIndex) {
+        const int priorIndex = index - 1;
+        const SCDateTime priorDateTime = sc.BaseDateTimeIn[priorIndex];
+        const int priorMinute = MinuteOfDay(priorDateTime);
+
+        if(priorIndex > 0 && priorMinute != MinuteOfDay(sc.BaseDateTimeIn[index]) && priorDateTime > state.lastUpdateDateTime) {
+            UpdateActivityProfile(profile, priorMinute, barCountSubgraph[priorIndex], sc.Input[PROFILE_SESSIONS_INPUT].GetInt());
+            state.lastUpdateDateTime = priorDateTime;
+        }
+
+        // Save the profile once a day, so that a crash loses at most one session.
+        if(!sc.IsFullRecalculation && priorDateTime.GetDate() != sc.BaseDateTimeIn[index].GetDate()) SaveActivityProfile(sc, state);
+
+        profileLastIndex = index;
+    }
+
+    /* The profile loaded from disk already includes the bars up to when it was saved, and the sessions after them.
+     * Comparing those bars against it would use future data, so they get no expected bar count or Z-score.
+     */
+    if(sc.BaseDateTimeIn[index] <= state.loadedDateTime) {
+        sc.Subgraph[EXPECTED_BAR_COUNT_SUBGRAPH][index] = 0;
+        sc.Subgraph[Z_SCORE_SUBGRAPH][index] = 0;
+        return;
+    }
+
+    const int minute = MinuteOfDay(sc.BaseDateTimeIn[index]);
+    const double standardDeviation = sqrt(profile.variance[minute]);
+
+    sc.Subgraph[EXPECTED_BAR_COUNT_SUBGRAPH][index] = (float)profile.mean[minute];
+    sc.Subgraph[Z_SCORE_SUBGRAPH][index] = profile.sampleCount[minute] >= 2 && standardDeviation > 0
+        ? (float)((barCountSubgraph[index] - profile.mean[minute]) / standardDeviation)
+        : 0;
+}
+
+/* The study's loop, specialized for the duration unit, so that the duration is computed once per call
+ * rather than branched on for every bar.
+ */
+template<DurationUnitEnum Unit>
+void CalculateBarCountPerDuration(SCStudyInterfaceRef sc) {
+    SCSubgraphRef barCountSubgraph = sc.Subgraph[BAR_COUNT_SUBGRAPH];
+    SCDateTime& endDateTime = sc.GetPersistentSCDateTime(END_DATE_TIME_VARIABLE);
+    int& startTimeBarIndex = sc.GetPersistentInt(START_TIME_BAR_INDEX_VARIABLE);
+    ActivityProfileState* profile = static_cast<ActivityProfileState*>(sc.GetPersistentPointer(PROFILE_POINTER));
+    BarCountPerDurationKernel<SCDateTimeTraits, Unit> barCount(sc.Input[DURATION_VALUE_INPUT].GetInt(), endDateTime, startTimeBarIndex);
+    int index = sc.UpdateStartIndex;
+
+    if(index == 0) {
+        barCount.Start(sc.BaseDateTimeIn[0]);
+        index = 1;
+    }
 
-    return SCDateTime::SECONDS(duration);
+    for(; index < sc.ArraySize; index++) {
+        barCountSubgraph[index] = (float)barCount(sc.BaseDataEndDateTime, index);
+
+        if(profile != NULL) UpdateActivityProfileAt(sc, *profile, index);
+    }
 }
 
 SCSFExport scsf_BarCountPerDuration(SCStudyInterfaceRef sc) {
-    SCSubgraphRef barCountSubgraph = sc.Subgraph[0];
+    SCSubgraphRef barCountSubgraph = sc.Subgraph[BAR_COUNT_SUBGRAPH];
+    SCSubgraphRef zScoreSubgraph = sc.Subgraph[Z_SCORE_SUBGRAPH];
+    SCSubgraphRef expectedBarCountSubgraph = sc.Subgraph[EXPECTED_BAR_COUNT_SUBGRAPH];
     SCInputRef durationUnitInput = sc.Input[DURATION_UNIT_INPUT];
     SCInputRef durationValueInput = sc.Input[DURATION_VALUE_INPUT];
-    SCDateTime& endDateTime = sc.GetPersistentSCDateTime(END_DATE_TIME_VARIABLE);
-    int& startTimeBarIndex = sc.GetPersistentInt(START_TIME_BAR_INDEX_VARIABLE);
+    SCInputRef profileEnabledInput = sc.Input[PROFILE_ENABLED_INPUT];
+    SCInputRef profileSessionsInput = sc.Input[PROFILE_SESSIONS_INPUT];
+    int& profileLastIndex = sc.GetPersistentInt(PROFILE_LAST_INDEX_VARIABLE);
 
 	if(sc.SetDefaults) {
 		sc.GraphName = "Bar Count per Duration";
-        sc.StudyDescription = "This study counts the number of bars within the given duration. The duration can be provided in hours, minutes, or seconds.";
-		sc.AutoLoop = 1;
+        sc.StudyDescription = "This study counts the number of bars within the given duration. The duration can be provided in hours, minutes, or seconds. "
+            "Optionally, it keeps a time-of-day activity profile of the bar count, averaged over the given number of sessions and saved across chart reloads. "
+            "The Expected bar count subgraph then shows the profile's average for the bar's minute of the day, and the Z-score subgraph how far the bar count is from it, in standard deviations. "
+            "Bars which are already in the profile saved on disk are shown as 0, since the profile would otherwise score them against themselves.";
+		sc.AutoLoop = 0;
         sc.GraphRegion = 1;
         sc.MaintainAdditionalChartDataArrays = true; // Required for sc.BaseDataEndDateTime
 		
@@ -79,10 +270,29 @@ SCSFExport scsf_BarCountPerDuration(SCStudyInterfaceRef sc) {
         durationValueInput.Name = "Duration";
         durationValueInput.SetIntLimits(1, MAX_DURATION);
         durationValueInput.SetInt(1);
+
+        zScoreSubgraph.Name = "Z-score";
+        zScoreSubgraph.DrawStyle = DRAWSTYLE_IGNORE;
+
+        expectedBarCountSubgraph.Name = "Expected bar count";
+        expectedBarCountSubgraph.DrawStyle = DRAWSTYLE_LINE;
+        expectedBarCountSubgraph.PrimaryColor = RGB (128, 128, 128);
+
+        profileEnabledInput.Name = "Keep a time-of-day activity profile";
+        profileEnabledInput.SetYesNo(0);
+
+        profileSessionsInput.Name = "Activity profile sessions (N)";
+        profileSessionsInput.SetIntLimits(2, 1000);
+        profileSessionsInput.SetInt(20);
 		
 		return;
 	}
 
+    if(sc.LastCallToFunction) {
+        ReleaseActivityProfile(sc);
+        return;
+    }
+
     /* To understand how this study works, imagine that there's a string/cord which corresponds to the duration.
      * When the first bar is drawn on the chart, this study places both ends of the "string" at that first bar.
      * As bars continue to accumulate, one end of the string is left at that first bar, and the other end moves
@@ -92,31 +302,18 @@ SCSFExport scsf_BarCountPerDuration(SCStudyInterfaceRef sc) {
      * As this happens, bars on the tail-end of the "string" drop off, and are no longer counted.
      */
 
-    if(sc.IsFullRecalculation && sc.Index == 0) {
-        SCDateTime barStartDateTime = sc.BaseDateTimeIn[sc.Index];
-        endDateTime = barStartDateTime + GetDuration(static_cast<DurationUnitEnum>(durationUnitInput.GetIndex()), durationValueInput.GetInt());
-        startTimeBarIndex = 0;
+    if(sc.UpdateStartIndex == 0) {
+        profileLastIndex = 0;
 
-        return;
+        if(profileEnabledInput.GetYesNo()) LoadActivityProfile(sc);
+        else ReleaseActivityProfile(sc);
     }
 
-    SCDateTime barEndDateTime = sc.BaseDataEndDateTime[sc.Index];
-
-    if(barEndDateTime > endDateTime) {
-        SCDateTime startDateTime = barEndDateTime - GetDuration(static_cast<DurationUnitEnum>(durationUnitInput.GetIndex()), durationValueInput.GetInt());
-        endDateTime = barEndDateTime;
-
-        if(sc.BaseDataEndDateTime[startTimeBarIndex] < startDateTime) {
-            for(int i = startTimeBarIndex; i < sc.Index; i++) {
-                if(sc.BaseDataEndDateTime[i] < startDateTime) { 
-                    startTimeBarIndex++;
-                } else {
-                    // If the bar falls within the duration window, then there's no reason to keep looking.
-                    break;
-                }
-            }
-        }
-    }
+    if(sc.ArraySize == 0) return;
 
-    barCountSubgraph[sc.Index] = sc.Index - startTimeBarIndex + 1;
+    switch(static_cast<DurationUnitEnum>(durationUnitInput.GetIndex())) {
+        case DURATION_HOURS: CalculateBarCountPerDuration<DURATION_HOURS>(sc); break;
+        case DURATION_MINUTES: CalculateBarCountPerDuration<DURATION_MINUTES>(sc); break;
+        default: CalculateBarCountPerDuration<DURATION_SECONDS>(sc); break;
+    }
 }
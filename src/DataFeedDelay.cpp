@@ -5,7 +5,11 @@
 
    These studies expect the chart's time zone to match your operating system's time zone.
 
-   These studies automatically disable themselves during a chart replay.
+   With the live delay source, these studies automatically disable themselves during a chart replay.
+
+   To test the alert without waiting for a real feed outage, set the delay source to one of the synthetic patterns
+   (see DataFeedDelayKernels.h). The bid/ask timestamps are then generated against a stand-in clock,
+   which follows the replay during a chart replay, so the studies keep running then. See also tools/FeedDelayLoadGen.cpp.
    
    MIT License
    
@@ -31,8 +35,19 @@
 */
 
 #include "sierrachart.h"
+#include "DataFeedDelayKernels.h"
 SCDLLName("Data Feed Delay")
 
+enum DelaySourceEnum {
+    DELAY_SOURCE_LIVE
+    , DELAY_SOURCE_SYNTHETIC_SPIKES
+    , DELAY_SOURCE_SYNTHETIC_DRIFT
+    , DELAY_SOURCE_SYNTHETIC_FLAPPING
+};
+
+const SCString DELAY_SOURCE_OPTIONS = "Live;Synthetic spikes;Synthetic drift;Synthetic flapping";
+const double SECONDS_PER_DAY = 86400.0;
+
 int inline DataFeedDelay(SCStudyInterfaceRef sc) {
     SCDateTime lastBidAskUpdateDateTime = sc.SymbolData->LastBidAskUpdateDateTime;
 
@@ -42,10 +57,31 @@ int inline DataFeedDelay(SCStudyInterfaceRef sc) {
     return (sc.CurrentSystemDateTime - lastBidAskUpdateDateTime).GetTimeInSeconds();
 }
 
+// The clock the synthetic delay is measured against: the replay's date-time during a chart replay, otherwise the system's.
+SCDateTime inline StandInClock(SCStudyInterfaceRef sc) {
+    return sc.IsReplayRunning() ? sc.LatestDateTimeForLastBar : sc.CurrentSystemDateTime;
+}
+
+int inline SyntheticDataFeedDelay(const SCDateTime& clock, int delaySource, int threshold) {
+    const double clockSeconds = clock.GetAsDouble() * SECONDS_PER_DAY;
+    const SyntheticFeedPatternEnum pattern = static_cast<SyntheticFeedPatternEnum>(delaySource - DELAY_SOURCE_SYNTHETIC_SPIKES);
+
+    return FeedDelaySeconds(clockSeconds, SyntheticBidAskUpdateTime(pattern, threshold, clockSeconds));
+}
+
+void inline SetDelaySourceDefaults(SCInputRef delaySource) {
+    delaySource.Name = "Delay source";
+    delaySource.SetCustomInputStrings(DELAY_SOURCE_OPTIONS);
+    delaySource.SetCustomInputIndex(DELAY_SOURCE_LIVE);
+}
+
 SCSFExport scsf_DataFeedDelayStudy(SCStudyInterfaceRef sc) {
 
     SCSubgraphRef delay = sc.Subgraph[0];
 
+    SCInputRef delaySource = sc.Input[0];
+    SCInputRef syntheticThreshold = sc.Input[1];
+
 	if(sc.SetDefaults) {
 		sc.GraphName = "Data Feed Delay Study";
         sc.StudyDescription = "Compares the current date/time with the date/time of the last bid/ask update, to compute the data feed delay in seconds. This study expects the chart's time zone to match your operating system's time zone.";
@@ -57,10 +93,22 @@ SCSFExport scsf_DataFeedDelayStudy(SCStudyInterfaceRef sc) {
         delay.DrawStyle = DRAWSTYLE_IGNORE;
         delay.PrimaryColor = COLOR_GREEN;
 
+        SetDelaySourceDefaults(delaySource);
+
+        syntheticThreshold.Name = "Synthetic delay threshold (in seconds)";
+        syntheticThreshold.SetIntLimits(1, 1800);
+        syntheticThreshold.SetInt(10);
+
 		return;
 	}
 
     if(sc.IsFullRecalculation) return;
+
+    if(delaySource.GetIndex() != DELAY_SOURCE_LIVE) {
+        delay[sc.Index] = SyntheticDataFeedDelay(StandInClock(sc), delaySource.GetIndex(), syntheticThreshold.GetInt());
+        return;
+    }
+
     if(sc.IsReplayRunning()) return;
 
     delay[sc.Index] = DataFeedDelay(sc);
@@ -74,6 +122,7 @@ SCSFExport scsf_DataFeedDelayAlertStudy(SCStudyInterfaceRef sc) {
     SCInputRef alertNumber = sc.Input[1];
     SCInputRef snoozeLength = sc.Input[2];
     SCInputRef sessionType = sc.Input[3];
+    SCInputRef delaySource = sc.Input[4];
 
     int &allowAlert = sc.GetPersistentInt(0);
     int &snoozeMenuId = sc.GetPersistentInt(1);
@@ -81,6 +130,8 @@ SCSFExport scsf_DataFeedDelayAlertStudy(SCStudyInterfaceRef sc) {
     int &isSnoozed = sc.GetPersistentInt(3);
     SCDateTime &snoozeEndDateTime = sc.GetPersistentSCDateTime(0);
 
+    DataFeedDelayAlertKernel<SCDateTime> alert(allowAlert, isSnoozed, snoozeEndDateTime);
+
 	if(sc.SetDefaults) {
 		sc.GraphName = "Data Feed Delay Alert Study";
         sc.StudyDescription = "Compares the current date/time with the date/time of the last bid/ask update, to compute the data feed delay in seconds. If the delay exceeds the given threshold then the study issues an alert. The alert will continue to trigger until the data feed delay drops below the threshold. The alert can be snoozed via the chart's context (right-click) menu. Note: This study expects the chart's time zone to match your operating system's time zone.";
@@ -108,6 +159,8 @@ SCSFExport scsf_DataFeedDelayAlertStudy(SCStudyInterfaceRef sc) {
         sessionType.SetCustomInputStrings("Day session;Evening session"); 
         sessionType.SetCustomInputIndex(0);
 
+        SetDelaySourceDefaults(delaySource);
+
 		return;
 	}
 
@@ -116,17 +169,18 @@ SCSFExport scsf_DataFeedDelayAlertStudy(SCStudyInterfaceRef sc) {
         return;
     }
 
+    const bool isLive = delaySource.GetIndex() == DELAY_SOURCE_LIVE;
+
     if(sc.Index == 0) {
         SCString snoozeMenuText, testMenuText;
 
-        allowAlert = true;
-        isSnoozed = false;
+        alert.Reset();
         snoozeMenuText.Format("Snooze data feed delay alert (study ID %i)", sc.StudyGraphInstanceID);
         testMenuText.Format("Test data feed delay alert (study ID %i)", sc.StudyGraphInstanceID);
 
         if(snoozeMenuId >= 0) sc.RemoveACSChartShortcutMenuItem(sc.ChartNumber, snoozeMenuId);
         if(testMenuId >= 0) sc.RemoveACSChartShortcutMenuItem(sc.ChartNumber, testMenuId);
-        if(!sc.IsReplayRunning()) {
+        if(!isLive || !sc.IsReplayRunning()) {
             snoozeMenuId = sc.AddACSChartShortcutMenuItem(sc.ChartNumber, snoozeMenuText);
             testMenuId = sc.AddACSChartShortcutMenuItem(sc.ChartNumber, testMenuText);
 
@@ -136,45 +190,29 @@ SCSFExport scsf_DataFeedDelayAlertStudy(SCStudyInterfaceRef sc) {
     }
 
     if(sc.IsFullRecalculation) return;
-    if(sc.IsReplayRunning()) return;
-
-    delay[sc.Index] = DataFeedDelay(sc);
-    
-    if(isSnoozed) {
-        if(sc.CurrentSystemDateTime > snoozeEndDateTime) isSnoozed = false;
-    }
+    if(isLive && sc.IsReplayRunning()) return;
 
-    if(isSnoozed) return;
+    const SCDateTime now = isLive ? sc.CurrentSystemDateTime : StandInClock(sc);
+    delay[sc.Index] = isLive ? DataFeedDelay(sc) : SyntheticDataFeedDelay(now, delaySource.GetIndex(), delayThreshold.GetInt());
 
     // Automatically disable monitoring when outside of the selected trading session.
     const bool monitorDataFeedDelay = sessionType.GetIndex() == 0 ? sc.IsDateTimeInDaySession(sc.BaseDateTimeIn[sc.Index]) : sc.IsDateTimeInEveningSession(sc.BaseDateTimeIn[sc.Index]);
 
-    bool triggerAlertTest = sc.MenuEventID == testMenuId;
+    const int events = alert(delay[sc.Index], delayThreshold.GetInt(), monitorDataFeedDelay, now, SCDateTime::SECONDS(snoozeLength.GetInt()), sc.MenuEventID == snoozeMenuId, sc.MenuEventID == testMenuId);
 
-    if(monitorDataFeedDelay && delay[sc.Index] > delayThreshold.GetInt()) {
-        if(allowAlert) {
-            SCString msg;
-
-            msg.Format("The data feed is delayed by %f seconds, exceeding the threshold of %d seconds.", delay[sc.Index], delayThreshold.GetInt());
-            sc.SetAlert(alertNumber.GetInt(), msg);
-            allowAlert = false;
-        } else {
-            allowAlert = true;
-        }
+    if(events & FEED_DELAY_ALERT) {
+        SCString msg;
 
-        if(sc.MenuEventID == snoozeMenuId) {
-            SCString msg;
+        msg.Format("The data feed is delayed by %f seconds, exceeding the threshold of %d seconds.", delay[sc.Index], delayThreshold.GetInt());
+        sc.SetAlert(alertNumber.GetInt(), msg);
+    }
 
-            SCDateTime snoozeDelay = sc.CurrentSystemDateTime;
-            snoozeDelay += SCDateTime::SECONDS(snoozeLength.GetInt());
-            snoozeEndDateTime = snoozeDelay;
-            isSnoozed = true;
-            msg.Format("Alert has been snoozed for %d seconds.", snoozeLength.GetInt());
-            sc.AddAlertLine(msg, 0);
-        }
-    } else {
-        allowAlert = true;
+    if(events & FEED_DELAY_SNOOZE_STARTED) {
+        SCString msg;
 
-        if(triggerAlertTest) sc.SetAlert(alertNumber.GetInt(), "Testing data feed delay alert.");
+        msg.Format("Alert has been snoozed for %d seconds.", snoozeLength.GetInt());
+        sc.AddAlertLine(msg, 0);
     }
+
+    if(events & FEED_DELAY_TEST_ALERT) sc.SetAlert(alertNumber.GetInt(), "Testing data feed delay alert.");
 }
@@ -0,0 +1,150 @@
+/* DataFeedDelayKernels.h
+
+   The logic of the data feed delay studies, written without sierrachart.h,
+   so that the studies and tools/FeedDelayLoadGen.cpp run exactly the same code:
+
+       - A synthetic bid/ask timestamp source, which replays delay patterns against a stand-in clock.
+       - The delay computation.
+       - The alert state machine, including the snooze.
+
+   Times are in seconds. The synthetic source and the delay only depend on the clock's value, not on its epoch.
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#ifndef DATA_FEED_DELAY_KERNELS_H
+#define DATA_FEED_DELAY_KERNELS_H
+
+#include <math.h>
+
+// How often a healthy synthetic feed updates the bid/ask.
+const double SYNTHETIC_FEED_UPDATES_PER_SECOND = 4.0;
+
+/* The synthetic delay patterns. Each is scaled by the alert threshold, so that it exercises the alert the same way at any setting.
+ *
+ *     Spikes:   The feed stalls for 0.5, 1, then 1.5 times the threshold, and then 2 times the threshold plus 2 seconds,
+ *               once every 6 times the threshold. The 1x stall peaks exactly at the threshold, and so must not alert.
+ *               Since the delay is reported in whole seconds, rounded down, the extra 2 seconds ensure that
+ *               the longest stall alerts even at a threshold of 1 second.
+ *     Drift:    The feed falls behind, and catches up, slowly: from 0 to 2 times the threshold and back, over 20 times the threshold.
+ *     Flapping: The delay alternates between just under and just over the threshold, every second.
+ */
+enum SyntheticFeedPatternEnum {
+    FEED_PATTERN_SPIKES
+    , FEED_PATTERN_DRIFT
+    , FEED_PATTERN_FLAPPING
+};
+
+// The date-time of the last update of a healthy feed.
+inline double SyntheticFeedTick(double clock) {
+    return floor(clock * SYNTHETIC_FEED_UPDATES_PER_SECOND) / SYNTHETIC_FEED_UPDATES_PER_SECOND;
+}
+
+// Returns the date-time of the last bid/ask update, at the given clock.
+inline double SyntheticBidAskUpdateTime(SyntheticFeedPatternEnum pattern, int threshold, double clock) {
+    switch(pattern) {
+        case FEED_PATTERN_SPIKES: {
+            const double period = 6.0 * threshold;
+            const double phase = fmod(clock, period);
+            const int spike = (int)fmod(floor(clock / period), 4.0);
+            const double stall = spike < 3 ? 0.5 * threshold * (spike + 1) : 2.0 * threshold + 2;
+
+            // During a stall, the timestamp stays at the start of the period.
+            return phase < stall ? clock - phase : SyntheticFeedTick(clock);
+        }
+
+        case FEED_PATTERN_DRIFT: {
+            const double phase = fmod(clock, 20.0 * threshold) / (20.0 * threshold);
+            const double lag = 2.0 * threshold * (phase < 0.5 ? 2 * phase : 2 - 2 * phase);
+
+            return SyntheticFeedTick(clock - lag);
+        }
+
+        default:
+            return clock - threshold - (fmod(floor(clock), 2.0) == 0 ? -1 : 1);
+    }
+}
+
+// The delay in whole seconds, as the studies report it: the last update is rounded down to the second.
+inline int FeedDelaySeconds(double clock, double lastBidAskUpdateTime) {
+    return (int)(clock - floor(lastBidAskUpdateTime));
+}
+
+enum DataFeedDelayAlertEventEnum {
+    FEED_DELAY_NO_EVENT = 0
+    , FEED_DELAY_ALERT = 1
+    , FEED_DELAY_TEST_ALERT = 2
+    , FEED_DELAY_SNOOZE_STARTED = 4
+};
+
+/* The alert logic of scsf_DataFeedDelayAlertStudy, run once per update.
+ * While the delay exceeds the threshold, the alert triggers on every other update, until the delay drops or the alert is snoozed.
+ * allowAlert, isSnoozed and snoozeEndDateTime are the state, and TimeT is the caller's date-time type.
+ */
+template<typename TimeT>
+class DataFeedDelayAlertKernel {
+public:
+    DataFeedDelayAlertKernel(int& allowAlert, int& isSnoozed, TimeT& snoozeEndDateTime)
+        : allowAlert(allowAlert), isSnoozed(isSnoozed), snoozeEndDateTime(snoozeEndDateTime) {}
+
+    void Reset() {
+        allowAlert = true;
+        isSnoozed = false;
+    }
+
+    // Returns the DataFeedDelayAlertEventEnum's to act on, combined.
+    int operator()(float delay, int threshold, bool inSession, const TimeT& now, const TimeT& snoozeLength, bool snoozeRequested, bool testRequested) {
+        int events = FEED_DELAY_NO_EVENT;
+
+        if(isSnoozed && now > snoozeEndDateTime) isSnoozed = false;
+        if(isSnoozed) return events;
+
+        if(inSession && delay > threshold) {
+            if(allowAlert) {
+                events |= FEED_DELAY_ALERT;
+                allowAlert = false;
+            } else {
+                allowAlert = true;
+            }
+
+            if(snoozeRequested) {
+                snoozeEndDateTime = now + snoozeLength;
+                isSnoozed = true;
+                events |= FEED_DELAY_SNOOZE_STARTED;
+            }
+        } else {
+            allowAlert = true;
+
+            if(testRequested) events |= FEED_DELAY_TEST_ALERT;
+        }
+
+        return events;
+    }
+
+private:
+    int& allowAlert;
+    int& isSnoozed;
+    TimeT& snoozeEndDateTime;
+};
+
+#endif
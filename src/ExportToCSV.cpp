@@ -2,6 +2,9 @@
 
    This study exports 11 subgraphs to a (comma-separated-value (CSV) file, for easy import into a spreadsheet application such as Microsoft Excel. The study will continue to append data to the CSV file as long as it's running. Note: The last bar's data is not exported.
 
+   After each export the study saves a checkpoint (see StudyCheckpoint.h). When the chart is reloaded, and the checkpoint is still valid
+   for the chart's data, the rows already in the CSV file are kept and only the newer bars are appended, rather than rewriting the whole file.
+
    MIT License
    
    Copyright (c) 2025 Emmanuel Rosa
@@ -26,32 +29,217 @@
 */
 
 #include "sierrachart.h"
+#include "StudyCheckpoint.h"
 SCDLLName("Export to CSV")
 #include <random>
 
-/* A pseudo higher-order function which iterates through the SCInputRef's which are used to specify the subgraphs to export.
- * Implemented as a macro because lamdas don't work in Sierra Chart studies.
+const int EXPORT_CHECKPOINT_VERSION = 1;
+
+const int DATA_INPUT_START = 2;
+const int DATA_INPUT_COUNT = 11;
+const int ROW_BATCH_BYTES = 65536;
+const int CHECKPOINT_INTERVAL_SECONDS = 5;
+
+enum HeaderFormatEnum {
+    HEADER_CHART_STUDY_SUBGRAPH
+    , HEADER_STUDY_SUBGRAPH
+    , HEADER_SUBGRAPH
+};
+
+/* A higher-order function which iterates through the SCInputRef's which are used to specify the subgraphs to export.
+ * The functors are plain structs because lamdas don't work in Sierra Chart studies.
+ * Being templates, they're inlined into the loop.
  */
-#define ForEachDataInput { \
-    const unsigned int INPUT_INDEX_START = 2; \
-    const unsigned int INPUT_INDEX_END = 12; \
-    for(int i = INPUT_INDEX_START; i <= INPUT_INDEX_END; i++) { \
-        SCInputRef input = sc.Input[i]; \
-        unsigned index = i - INPUT_INDEX_START; \
+template<typename FunctorT>
+void ForEachDataInput(SCStudyInterfaceRef sc, FunctorT& functor) {
+    for(int index = 0; index < DATA_INPUT_COUNT; index++) {
+        functor(sc.Input[DATA_INPUT_START + index], index);
+    }
+}
 
-#define EndForEach }}
+struct SetDataInputDefaults {
+    SCStudyInterfaceRef sc;
 
-SCSFExport scsf_ExportSubgraphsToCSV(SCStudyInterfaceRef sc) {
+    void operator()(SCInputRef input, int index) {
+        input.Name.Format("Subgraph to export #%d", index + 1);
+        input.SetChartStudySubgraphValues(sc.ChartNumber, 0, index);
+    }
+};
+
+struct GetDataInputArray {
+    SCStudyInterfaceRef sc;
+    SCSubgraphRef subgraph;
+
+    void operator()(SCInputRef input, int index) {
+        sc.GetStudyArrayFromChartUsingID(input.GetChartStudySubgraphValues(), subgraph.Arrays[index]);
+    }
+};
+
+struct AddDataInputToFingerprint {
+    StudyFingerprint& fingerprint;
+
+    void operator()(SCInputRef input, int) {
+        fingerprint.Add(input.GetChartStudySubgraphValues());
+    }
+};
+
+// Appends a header column. Specialized by header format, which is selected once, rather than for each column.
+template<HeaderFormatEnum Format>
+struct AppendHeaderColumn {
+    SCStudyInterfaceRef sc;
+    SCString& buffer;
+
+    void operator()(SCInputRef input, int) {
+        SCString subgraphName;
+        s_ChartStudySubgraphValues sv = input.GetChartStudySubgraphValues();
+
+        subgraphName.Format("SG%d", sv.SubgraphIndex + 1);
+        sc.GetStudySubgraphNameFromChart(sc.ChartNumber, sv.StudyID, sv.SubgraphIndex, subgraphName);
+        Append(sv, subgraphName);
+    }
+
+    void Append(const s_ChartStudySubgraphValues& sv, const SCString& subgraphName);
+};
+
+template<>
+void AppendHeaderColumn<HEADER_CHART_STUDY_SUBGRAPH>::Append(const s_ChartStudySubgraphValues& sv, const SCString& subgraphName) {
+    buffer.AppendFormat(",\"%s %s %s\"", sc.GetChartName(sv.ChartNumber).GetChars(), sc.GetStudyNameFromChart(sv.ChartNumber, sv.StudyID).GetChars(), subgraphName.GetChars());
+}
+
+template<>
+void AppendHeaderColumn<HEADER_STUDY_SUBGRAPH>::Append(const s_ChartStudySubgraphValues& sv, const SCString& subgraphName) {
+    buffer.AppendFormat(",\"%s %s\"", sc.GetStudyNameFromChart(sv.ChartNumber, sv.StudyID).GetChars(), subgraphName.GetChars());
+}
+
+template<>
+void AppendHeaderColumn<HEADER_SUBGRAPH>::Append(const s_ChartStudySubgraphValues&, const SCString& subgraphName) {
+    buffer.AppendFormat(",\"%s\"", subgraphName.GetChars());
+}
+
+template<HeaderFormatEnum Format>
+void AppendHeader(SCStudyInterfaceRef sc, SCString& buffer) {
+    AppendHeaderColumn<Format> appendColumn = { sc, buffer };
+    ForEachDataInput(sc, appendColumn);
+}
+
+// Appends a row of data.
+void AppendRow(SCStudyInterfaceRef sc, SCSubgraphRef data, int row, SCString& buffer) {
+    buffer.AppendFormat("\"%s\"", sc.DateTimeToString(sc.BaseDateTimeIn[row], FLAG_DT_COMPLETE_DATETIME).GetChars());
+
+    for(int column = 0; column < DATA_INPUT_COUNT; column++) {
+        buffer.AppendFormat(",\"%f\"", data.Arrays[column][row]);
+    }
+
+    buffer.Append("\r\n");
+}
+
+void WriteBuffer(SCStudyInterfaceRef sc, int fileHandle, const SCString& buffer) {
+    unsigned int bytesWritten = 0;
+
+    if(!sc.WriteFile(fileHandle, buffer.GetChars(), buffer.GetLength(), &bytesWritten)) sc.AddMessageToLog(sc.GetLastFileErrorMessage(fileHandle), 1);
+}
+
+/* The checkpoint's payload. The rows exported so far are those before the checkpoint's bar.
+ * The first bar's date-time is kept too, since the CSV file no longer matches the chart if older data was loaded or trimmed.
+ */
+struct ExportCheckpoint {
+    double firstDateTime;
+};
+
+StudyFingerprint ExportFingerprint(SCStudyInterfaceRef sc) {
+    StudyFingerprint fingerprint = BeginStudyFingerprint(sc, EXPORT_CHECKPOINT_VERSION);
+    SCString outputFile = sc.Input[0].GetPathAndFileName();
+    AddDataInputToFingerprint addDataInput = { fingerprint };
+
+    fingerprint.Add(outputFile.GetChars()).Add(sc.Input[1].GetIndex());
+    ForEachDataInput(sc, addDataInput);
+
+    return fingerprint;
+}
+
+/* Returns the index of the first bar which hasn't been exported yet, according to the checkpoint,
+ * or -1 when the CSV file has to be rewritten.
+ */
+int GetResumeIndex(SCStudyInterfaceRef sc, const SCString& outputFile) {
+    ExportCheckpoint checkpoint;
+    int fileHandle = 0;
+
+    const int index = ReadStudyCheckpoint(sc, StudyCheckpointPath(sc, "export"), ExportFingerprint(sc), &checkpoint, sizeof(checkpoint));
+    if(index < 0 || sc.BaseDateTimeIn[0].GetAsDouble() != checkpoint.firstDateTime) return -1;
+
+    // Appending to a CSV file which was deleted would produce one without a header or its older rows.
+    if(!sc.OpenFile(outputFile, n_ACSIL::FILE_MODE_OPEN_EXISTING_FOR_SEQUENTIAL_READING, fileHandle)) return -1;
+    sc.CloseFile(fileHandle);
+
+    return index;
+}
+
+/* Exports the rows from lastIndex up to, but not including, endIndex, preceded by the header if it hasn't been written yet.
+ * Then updates the checkpoint, so that it always matches the rows in the file.
+ */
+void ExportRows(SCStudyInterfaceRef sc, int fileHandle, int endIndex, int& lastIndex, int& exportHeader, int& checkpointErrorLogged) {
     SCSubgraphRef dummySubgraph = sc.Subgraph[0];
+    GetDataInputArray getArray = { sc, dummySubgraph };
+    ForEachDataInput(sc, getArray);
+
+    // Construct the header row of the CSV file, and write it.
+    if(exportHeader) {
+        SCString headerStringBuffer = "\"Date Time\"";
+
+        switch(sc.Input[1].GetIndex()) {
+            case HEADER_CHART_STUDY_SUBGRAPH: AppendHeader<HEADER_CHART_STUDY_SUBGRAPH>(sc, headerStringBuffer); break;
+            case HEADER_STUDY_SUBGRAPH: AppendHeader<HEADER_STUDY_SUBGRAPH>(sc, headerStringBuffer); break;
+            default: AppendHeader<HEADER_SUBGRAPH>(sc, headerStringBuffer); break;
+        }
+        headerStringBuffer.Append("\r\n");
+
+        WriteBuffer(sc, fileHandle, headerStringBuffer);
+        exportHeader = false;
+    }
+
+    // Write the rows in batches, rather than one at a time, since the first export can be the whole chart.
+    SCString dataStringBuffer;
+
+    for(int row = max(0, lastIndex); row < endIndex; row++) {
+        AppendRow(sc, dummySubgraph, row, dataStringBuffer);
+
+        if(dataStringBuffer.GetLength() >= ROW_BATCH_BYTES) {
+            WriteBuffer(sc, fileHandle, dataStringBuffer);
+            dataStringBuffer = "";
+        }
+    }
+
+    if(dataStringBuffer.GetLength() > 0) WriteBuffer(sc, fileHandle, dataStringBuffer);
+
+    lastIndex = endIndex;
+
+    if(sc.Input[13].GetYesNo()) {
+        ExportCheckpoint checkpoint;
+
+        checkpoint.firstDateTime = sc.BaseDateTimeIn[0].GetAsDouble();
+
+        if(WriteStudyCheckpoint(sc, StudyCheckpointPath(sc, "export"), ExportFingerprint(sc), sc.BaseDateTimeIn[lastIndex], &checkpoint, sizeof(checkpoint))) {
+            checkpointErrorLogged = false;
+        } else if(!checkpointErrorLogged) {
+            sc.AddMessageToLog("ERROR: Unable to write the export checkpoint. After a chart reload, the CSV file will be re-written.", 1);
+            checkpointErrorLogged = true;
+        }
+    }
+}
+
+SCSFExport scsf_ExportSubgraphsToCSV(SCStudyInterfaceRef sc) {
     SCInputRef outputFileInput = sc.Input[0];
     SCInputRef headerFormatInput = sc.Input[1];
+    SCInputRef resumeInput = sc.Input[13];
     int &fileHandle = sc.GetPersistentInt(0);
     int &lastIndex = sc.GetPersistentInt(1);
     int &exportHeader = sc.GetPersistentInt(2);
+    int &checkpointErrorLogged = sc.GetPersistentInt(3);
+    SCDateTime &lastExportDateTime = sc.GetPersistentSCDateTime(0);
 
 	if(sc.SetDefaults) {
         sc.GraphName = "Export 11 Subgraphs to CSV";
-        sc.StudyDescription = "This study exports 11 subgraphs to a (comma-separated-value (CSV) file, for easy import into a spreadsheet application such as Microsoft Excel. The study will continue to append data to the CSV file as long as it's running. Note: The last bar's data is not exported.";
+        sc.StudyDescription = "This study exports 11 subgraphs to a (comma-separated-value (CSV) file, for easy import into a spreadsheet application such as Microsoft Excel. The study will continue to append data to the CSV file as long as it's running. Note: The last bar's data is not exported. When resuming the export after a chart reload is enabled, new rows are written at most every 5 seconds, along with the checkpoint which records them.";
         sc.AutoLoop = 1;
         sc.UpdateAlways = 1;
 
@@ -65,18 +253,24 @@ SCSFExport scsf_ExportSubgraphsToCSV(SCStudyInterfaceRef sc) {
         headerFormatInput.SetCustomInputStrings("Chart, study, & subgraph names;Study & subgraph names;Subgraph name"); 
         headerFormatInput.SetCustomInputIndex(0);
 		
-        ForEachDataInput
-            input.Name.Format("Subgraph to export #%d", index + 1);
-            input.SetChartStudySubgraphValues(sc.ChartNumber, 0, index);
-        EndForEach
+        SetDataInputDefaults setDefaults = { sc };
+        ForEachDataInput(sc, setDefaults);
+
+        resumeInput.Name = "Resume the export after a chart reload";
+        resumeInput.SetYesNo(1);
 
 		return;
 	}
 
     /* When the study recalculates, close the file if it's already open, and reopen it.
      * This causes the file to be re-written to avoid duplicating data.
+     * On the first calculation after a chart reload, when no file is open yet, a valid checkpoint shows which rows
+     * the file already holds, and the file is appended to instead. Other recalculations, such as after an exported
+     * study's inputs change, may have changed those rows, so they always re-write the file.
      */
     if(sc.Index == 0) {
+        const bool isReload = fileHandle == 0;
+
         lastIndex = -1;
         exportHeader = true;
 
@@ -87,8 +281,16 @@ SCSFExport scsf_ExportSubgraphsToCSV(SCStudyInterfaceRef sc) {
 
         if(fileHandle == 0) {
             int handle = 0;
+            int fileMode = n_ACSIL::FILE_MODE_OPEN_TO_REWRITE_FROM_START;
+            const int resumeIndex = isReload && resumeInput.GetYesNo() ? GetResumeIndex(sc, outputFileInput.GetPathAndFileName()) : -1;
+
+            if(resumeIndex >= 0) {
+                fileMode = n_ACSIL::FILE_MODE_OPEN_TO_APPEND;
+                lastIndex = resumeIndex;
+                exportHeader = false;
+            }
 
-            if(!sc.OpenFile(outputFileInput.GetPathAndFileName(), n_ACSIL::FILE_MODE_OPEN_TO_REWRITE_FROM_START, handle)) {
+            if(!sc.OpenFile(outputFileInput.GetPathAndFileName(), fileMode, handle)) {
                 sc.AddMessageToLog("ERROR: Unable to open the file.", 1);
             }
 
@@ -98,12 +300,16 @@ SCSFExport scsf_ExportSubgraphsToCSV(SCStudyInterfaceRef sc) {
 
     /* Close the file when the study is removed from the chart,
      * or when the study DLL is unloaded.
+     * Any rows held back by the checkpoint interval are exported first, so that the next reload resumes after them.
      */
     if(sc.LastCallToFunction) {
         if(fileHandle) {
+            if(lastIndex >= 0 && sc.ArraySize - 1 > lastIndex) ExportRows(sc, fileHandle, sc.ArraySize - 1, lastIndex, exportHeader, checkpointErrorLogged);
             if(!sc.CloseFile(fileHandle)) sc.AddMessageToLog(sc.GetLastFileErrorMessage(fileHandle), 1);
             fileHandle = 0;
         }
+
+        return;
     }
 
     /* Wait until the study recalculation is finished.
@@ -114,57 +320,16 @@ SCSFExport scsf_ExportSubgraphsToCSV(SCStudyInterfaceRef sc) {
 
     /* When a new bar opens, export the prior bar's subgraph data.
      * This also handles the first batch export.
+     * While the export is resumable, the rows and the checkpoint are written together at most once per checkpoint interval,
+     * rather than on every new bar. Since the study updates always, the rows held back are exported on a later call.
      */
     if(fileHandle != 0 && sc.Index > lastIndex) {
-        SCString headerStringBuffer;
-        int headerFormat = headerFormatInput.GetIndex();
-
-        ForEachDataInput
-            sc.GetStudyArrayFromChartUsingID(input.GetChartStudySubgraphValues(), dummySubgraph.Arrays[index]);
-        EndForEach
-
-        // Construct the header row of the CSV file, and write it.
-        if(exportHeader) {
-            unsigned int bytesWritten = 0;
-            headerStringBuffer = "\"Date Time\"";
-
-            ForEachDataInput
-                SCString subgraphName;
-                s_ChartStudySubgraphValues sv = input.GetChartStudySubgraphValues();
-
-                subgraphName.Format("SG%d", sv.SubgraphIndex + 1);
-                sc.GetStudySubgraphNameFromChart(sc.ChartNumber, sv.StudyID, sv.SubgraphIndex, subgraphName);
-
-                if(headerFormat == 0) {
-                    headerStringBuffer.AppendFormat(",\"%s %s %s\"", sc.GetChartName(sv.ChartNumber).GetChars(), sc.GetStudyNameFromChart(sv.ChartNumber, sv.StudyID).GetChars(), subgraphName.GetChars());
-                } else if(headerFormat == 1) {
-                    headerStringBuffer.AppendFormat(",\"%s %s\"", sc.GetStudyNameFromChart(sv.ChartNumber, sv.StudyID).GetChars(), subgraphName.GetChars());
-                } else {
-                    headerStringBuffer.AppendFormat(",\"%s\"", subgraphName.GetChars());
-                }
-            EndForEach
-            headerStringBuffer.Append("\r\n");
-
-            const char* buffer = headerStringBuffer.GetChars();
-            if(!sc.WriteFile(fileHandle, buffer, headerStringBuffer.GetLength(), &bytesWritten)) sc.AddMessageToLog(sc.GetLastFileErrorMessage(fileHandle), 1);
-            exportHeader = false;
-        }
+        const bool isThrottled = resumeInput.GetYesNo() && lastIndex >= 0
+            && sc.CurrentSystemDateTime < lastExportDateTime + SCDateTime::SECONDS(CHECKPOINT_INTERVAL_SECONDS);
 
-        for(int row = max(0, lastIndex); row < sc.Index; row++) {
-            unsigned int bytesWritten = 0;
-            SCString dataStringBuffer;
-
-            dataStringBuffer.Format("\"%s\"", sc.DateTimeToString(sc.BaseDateTimeIn[row], FLAG_DT_COMPLETE_DATETIME).GetChars()); 
-
-            ForEachDataInput
-                dataStringBuffer.AppendFormat(",\"%f\"", dummySubgraph.Arrays[index][row]);
-            EndForEach
-            dataStringBuffer.Append("\r\n");
-
-            const char* buffer = dataStringBuffer.GetChars();
-            if(!sc.WriteFile(fileHandle, buffer, dataStringBuffer.GetLength(), &bytesWritten)) sc.AddMessageToLog(sc.GetLastFileErrorMessage(fileHandle), 1);
+        if(!isThrottled) {
+            ExportRows(sc, fileHandle, sc.Index, lastIndex, exportHeader, checkpointErrorLogged);
+            lastExportDateTime = sc.CurrentSystemDateTime;
         }
-
-        lastIndex = sc.Index;
     }
 }
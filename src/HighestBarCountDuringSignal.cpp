@@ -3,6 +3,8 @@
    This study counts the number of bars while the given subgraph value is non-zero. 
    Then it records the count when the signal changes to zero. 
    The subgraph produced by this study contains the count.
+   The signal can also be an expression over up to four subgraphs, such as A > B && C != 0.
+   See SignalExpression.h.
    
    MIT License
    
@@ -28,22 +30,24 @@
 */
 
 #include "sierrachart.h"
+#include "SignalInputs.h"
+#include "StudyKernels.h"
 SCDLLName("Highest Bar Count During Signal Study")
 
+const SignalInputIndexes SIGNAL_INPUTS = { { 0, 2, 3, 4 }, 1 };
+
 SCSFExport scsf_HighestBarCountDuringSignal(SCStudyInterfaceRef sc) {
     SCSubgraphRef count = sc.Subgraph[0];
-    SCInputRef signalInput = sc.Input[0];
-    SCFloatArray signal;
+    SCFloatArray operands[SIGNAL_OPERAND_COUNT];
     int& lastIndex = sc.GetPersistentInt(0);
     int& lastCount = sc.GetPersistentInt(1);
 
 	if(sc.SetDefaults) {
 		sc.GraphName = "Highest Bar Count During Signal Study";
-        sc.StudyDescription = "This study counts the number of bars while the given subgraph value is non-zero. Then it records the count when the signal changes to zero. The subgraph produced by this study contains the count.";
+        sc.StudyDescription = "This study counts the number of bars while the given subgraph value is non-zero. Then it records the count when the signal changes to zero. The subgraph produced by this study contains the count. The signal can also be an expression over up to four subgraphs, such as A > B && C != 0.";
 		sc.AutoLoop = 1;
         
-        signalInput.Name = "Subgraph to use as the signal to count.";
-        signalInput.SetChartStudySubgraphValues(1,1, 0);
+        SetSignalInputDefaults(sc, SIGNAL_INPUTS);
 
 		count.Name = "Count";
 		count.DrawStyle = DRAWSTYLE_LINE;
@@ -53,21 +57,27 @@ SCSFExport scsf_HighestBarCountDuringSignal(SCStudyInterfaceRef sc) {
 		return;
 	}
 
+    if(sc.LastCallToFunction) {
+        ReleaseSignalProgram(sc, 0);
+        return;
+    }
+
     if(sc.Index == 0) {
         lastIndex = -1;
         lastCount = 0;
     }
 
     const int priorIndex = sc.Index - 1;
-    sc.GetStudyArrayFromChartUsingID(signalInput.GetChartStudySubgraphValues(), signal);
+    const SignalProgram& program = GetSignalProgram(sc, SIGNAL_INPUTS, 0);
+    GetSignalOperands(sc, SIGNAL_INPUTS, program, operands);
+
+    HighestBarCountDuringSignalKernel highestCount(lastCount);
+
+    // The first bar has no prior bar to record.
+    if(sc.Index != lastIndex && sc.Index > 0) {
+        int recordedCount = 0;
 
-    if(sc.Index != lastIndex) {
-        if(signal[priorIndex] == 0) {
-            count[priorIndex] = lastCount;
-            lastCount = 0;
-        } else {
-            lastCount++;
-        }
+        if(highestCount(EvaluateSignalAt(program, operands, priorIndex), recordedCount)) count[priorIndex] = recordedCount;
 
         lastIndex = sc.Index;
     }
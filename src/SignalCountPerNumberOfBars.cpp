@@ -3,6 +3,8 @@
    This study counts the number of times the input signal contains a non-zero value, 
    during the given n number of bars. A percentage is also available as a second
    subgraph.
+   The signal can also be an expression over up to four subgraphs, such as A > B && C != 0.
+   See SignalExpression.h.
    
    MIT License
    
@@ -28,22 +30,25 @@
 */
 
 #include "sierrachart.h"
+#include "SignalInputs.h"
+#include "StudyKernels.h"
 SCDLLName("Signal Count per Number of Bars")
 
+const SignalInputIndexes SIGNAL_INPUTS = { { 0, 3, 4, 5 }, 2 };
+
 SCSFExport scsf_SignalCountPerNumberOfBars(SCStudyInterfaceRef sc) {
     SCSubgraphRef count = sc.Subgraph[0];
     SCSubgraphRef percentage = sc.Subgraph[1];
-    SCInputRef signal = sc.Input[0];
     SCInputRef length = sc.Input[1];
 
-    SCFloatArray signalData;
+    SCFloatArray operands[SIGNAL_OPERAND_COUNT];
 
     int& lastIndex = sc.GetPersistentInt(0);
-    int& lastCount = sc.GetPersistentInt(1);
+    int& priorCount = sc.GetPersistentInt(1);
 
 	if(sc.SetDefaults) {
 		sc.GraphName = "Signal Count per Number of Bars";
-        sc.StudyDescription = "This study counts the number of times the input signal contains a non-zero value, during the given n number of bars. A percentage is also available as a second subgraph.";
+        sc.StudyDescription = "This study counts the number of times the input signal contains a non-zero value, during the given n number of bars. A percentage is also available as a second subgraph. The signal can also be an expression over up to four subgraphs, such as A > B && C != 0.";
 		sc.AutoLoop = 1;
 		
 		count.Name = "Count";
@@ -53,35 +58,53 @@ SCSFExport scsf_SignalCountPerNumberOfBars(SCStudyInterfaceRef sc) {
 		percentage.Name = "Percentage";
 		percentage.DrawStyle = DRAWSTYLE_IGNORE;
 		
-		signal.Name = "Input signal";
-		signal.SetChartStudySubgraphValues(1, 1, 0);
-
 		length.Name = "Length";
 		length.SetInt(10);
+
+        SetSignalInputDefaults(sc, SIGNAL_INPUTS);
 		
 		return;
 	}
+
+    if(sc.LastCallToFunction) {
+        ReleaseSignalProgram(sc, 0);
+        return;
+    }
 	
     if(sc.Index == 0) {
         lastIndex = -1;
-        lastCount = 0;
+        priorCount = 0;
     }
 
-    if(sc.Index + 1 < length.GetInt()) return;
+    const SignalProgram& program = GetSignalProgram(sc, SIGNAL_INPUTS, 0);
+    SignalCountKernel signalCount(length.GetInt(), priorCount);
+
+    if(!signalCount.IsReady(sc.Index)) return;
 
-    sc.GetStudyArrayFromChartUsingID(signal.GetChartStudySubgraphValues(), signalData);
+    GetSignalOperands(sc, SIGNAL_INPUTS, program, operands);
 
+    /* Recount the prior bars whenever a new bar opens, rather than sliding the window by one bar,
+     * since the signal may come from a study which rewrites past bars.
+     */
     if(sc.Index != lastIndex) {
-        lastCount = 0;
+        float signalBlock[SIGNAL_BLOCK_SIZE];
+        priorCount = 0;
+
+        // Evaluate the signal over the prior bars a block at a time, rather than bar by bar.
+        for(int i = sc.Index - length.GetInt() + 1; i < sc.Index; i += SIGNAL_BLOCK_SIZE) {
+            const int blockLength = min(SIGNAL_BLOCK_SIZE, sc.Index - i);
 
-        for(int i = sc.Index - length.GetInt() + 1; i < sc.Index; i++) { 
-            if(signalData[i] != 0) lastCount++;
+            EvaluateSignalBlock(program, operands, i, blockLength, signalBlock);
+            for(int k = 0; k < blockLength; k++) {
+                if(signalBlock[k] != 0) priorCount++;
+            }
         }
 
         lastIndex = sc.Index;
     }
 
-    const int currentCount = signalData[sc.Index] == 0 ? lastCount : lastCount + 1;
+    const SignalArray signal(program, operands);
+    const int currentCount = signalCount(signal, sc.Index);
     count[sc.Index] = currentCount;
     percentage[sc.Index] = (float)currentCount / (float)length.GetInt();
 }
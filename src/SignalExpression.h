@@ -0,0 +1,370 @@
+/* SignalExpression.h
+
+   A small boolean expression language used by the signal counting studies to combine several subgraphs into one signal.
+   An expression such as "A > B && C != 0" is compiled once, into a compact postfix program, and then evaluated per bar,
+   or over a block of bars at a time.
+
+   Operands:    A, B, C, D (the study's signal inputs), and numeric constants such as 1.5 or -2.
+   Comparisons: ==, !=, >, >=, <, <=
+   Logic:       &&, ||, ! and parentheses.
+
+   An operand on its own is true when it's non-zero. An empty expression compiles to "A", which is the same as
+   counting a single subgraph's non-zero values.
+
+   This header doesn't depend on sierrachart.h.
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#ifndef SIGNAL_EXPRESSION_H
+#define SIGNAL_EXPRESSION_H
+
+#include <stdlib.h>
+
+const int SIGNAL_OPERAND_COUNT = 4;
+const int SIGNAL_MAX_INSTRUCTIONS = 32;
+const int SIGNAL_MAX_STACK_DEPTH = 8;
+const int SIGNAL_BLOCK_SIZE = 64;
+
+enum SignalOpcodeEnum {
+    SIGNAL_OP_OPERAND
+    , SIGNAL_OP_CONSTANT
+    , SIGNAL_OP_EQ
+    , SIGNAL_OP_NE
+    , SIGNAL_OP_GT
+    , SIGNAL_OP_GE
+    , SIGNAL_OP_LT
+    , SIGNAL_OP_LE
+    , SIGNAL_OP_AND
+    , SIGNAL_OP_OR
+    , SIGNAL_OP_NOT
+};
+
+struct SignalInstruction {
+    unsigned char opcode;
+    unsigned char operand;
+    float constant;
+};
+
+/* The compiled form of an expression.
+ * It's a plain struct so that it can live in memory obtained from the study's persistent pointer.
+ */
+struct SignalProgram {
+    int length;
+    unsigned int operandMask; // Bit n is set when operand n (A = 0) is referenced.
+    int errorPosition; // -1 when the expression compiled successfully.
+    SignalInstruction code[SIGNAL_MAX_INSTRUCTIONS];
+};
+
+/* A recursive-descent parser which emits postfix code as it goes.
+ * Precedence, from lowest to highest: ||, &&, !, comparisons, operands/constants/parentheses.
+ */
+class SignalExpressionParser {
+public:
+    SignalExpressionParser(const char* text, SignalProgram& program)
+        : text(text), position(0), depth(0), maxDepth(0), nesting(0), failed(false), program(program) {}
+
+    bool Compile() {
+        program.length = 0;
+        program.operandMask = 0;
+        program.errorPosition = -1;
+
+        SkipSpaces();
+
+        if(text[position] == '\0') {
+            EmitOperand(0);
+        } else {
+            ParseOr();
+            SkipSpaces();
+            if(text[position] != '\0') Fail();
+        }
+
+        if(failed) {
+            program.length = 0;
+            program.operandMask = 0;
+            program.errorPosition = position;
+        }
+
+        return !failed;
+    }
+
+private:
+    const char* text;
+    int position;
+    int depth;
+    int maxDepth;
+    int nesting;
+    bool failed;
+    SignalProgram& program;
+
+    void Fail() {
+        failed = true;
+    }
+
+    void SkipSpaces() {
+        while(text[position] == ' ' || text[position] == '\t') position++;
+    }
+
+    bool Accept(const char* token) {
+        SkipSpaces();
+
+        int length = 0;
+        while(token[length] != '\0') {
+            if(text[position + length] != token[length]) return false;
+            length++;
+        }
+
+        position += length;
+        return true;
+    }
+
+    // Tracks the stack depth the program will need, so that evaluation never overflows.
+    void Emit(unsigned char opcode, unsigned char operand, float constant, int stackChange) {
+        if(failed) return;
+        if(program.length == SIGNAL_MAX_INSTRUCTIONS) {
+            Fail();
+            return;
+        }
+
+        depth += stackChange;
+        if(depth > maxDepth) maxDepth = depth;
+        if(maxDepth > SIGNAL_MAX_STACK_DEPTH) {
+            Fail();
+            return;
+        }
+
+        SignalInstruction& instruction = program.code[program.length++];
+        instruction.opcode = opcode;
+        instruction.operand = operand;
+        instruction.constant = constant;
+    }
+
+    /* Bounds the recursion through nested parentheses and negations, so that a long input can't overflow the call stack.
+     * Any valid program fits in SIGNAL_MAX_INSTRUCTIONS, so it can't be nested deeper than that.
+     */
+    bool EnterNesting() {
+        if(++nesting > SIGNAL_MAX_INSTRUCTIONS) Fail();
+        return !failed;
+    }
+
+    void LeaveNesting() {
+        nesting--;
+    }
+
+    void EmitOperand(unsigned char operand) {
+        program.operandMask |= 1u << operand;
+        Emit(SIGNAL_OP_OPERAND, operand, 0, 1);
+    }
+
+    void ParseOr() {
+        ParseAnd();
+        while(!failed && Accept("||")) {
+            ParseAnd();
+            Emit(SIGNAL_OP_OR, 0, 0, -1);
+        }
+    }
+
+    void ParseAnd() {
+        ParseNot();
+        while(!failed && Accept("&&")) {
+            ParseNot();
+            Emit(SIGNAL_OP_AND, 0, 0, -1);
+        }
+    }
+
+    void ParseNot() {
+        SkipSpaces();
+
+        // Don't mistake "!=" for a negation.
+        if(text[position] == '!' && text[position + 1] != '=') {
+            position++;
+            if(!EnterNesting()) return;
+            ParseNot();
+            LeaveNesting();
+            Emit(SIGNAL_OP_NOT, 0, 0, 0);
+            return;
+        }
+
+        ParseComparison();
+    }
+
+    void ParseComparison() {
+        ParsePrimary();
+        if(failed) return;
+
+        unsigned char opcode;
+
+        // Two-character operators must be tried before their one-character prefixes.
+        if(Accept("==")) opcode = SIGNAL_OP_EQ;
+        else if(Accept("!=")) opcode = SIGNAL_OP_NE;
+        else if(Accept(">=")) opcode = SIGNAL_OP_GE;
+        else if(Accept("<=")) opcode = SIGNAL_OP_LE;
+        else if(Accept(">")) opcode = SIGNAL_OP_GT;
+        else if(Accept("<")) opcode = SIGNAL_OP_LT;
+        else return;
+
+        ParsePrimary();
+        Emit(opcode, 0, 0, -1);
+    }
+
+    void ParsePrimary() {
+        SkipSpaces();
+        const char c = text[position];
+
+        if(c == '(') {
+            position++;
+            if(!EnterNesting()) return;
+            ParseOr();
+            LeaveNesting();
+            if(!Accept(")")) Fail();
+            return;
+        }
+
+        if(c >= 'A' && c < 'A' + SIGNAL_OPERAND_COUNT) {
+            position++;
+            EmitOperand(c - 'A');
+            return;
+        }
+
+        if(c >= 'a' && c < 'a' + SIGNAL_OPERAND_COUNT) {
+            position++;
+            EmitOperand(c - 'a');
+            return;
+        }
+
+        if((c >= '0' && c <= '9') || c == '.' || c == '-') {
+            char* end = 0;
+            const float value = (float)strtod(text + position, &end);
+
+            if(end == text + position) {
+                Fail();
+                return;
+            }
+
+            position = (int)(end - text);
+            Emit(SIGNAL_OP_CONSTANT, 0, value, 1);
+            return;
+        }
+
+        Fail();
+    }
+};
+
+inline bool CompileSignalExpression(const char* text, SignalProgram& program) {
+    SignalExpressionParser parser(text, program);
+    return parser.Compile();
+}
+
+/* Evaluates the program for a single bar.
+ * operands[n] holds the value of operand n at that bar.
+ */
+inline bool EvaluateSignal(const SignalProgram& program, const float* operands) {
+    float stack[SIGNAL_MAX_STACK_DEPTH];
+    int top = -1;
+
+    for(int pc = 0; pc < program.length; pc++) {
+        const SignalInstruction& instruction = program.code[pc];
+
+        switch(instruction.opcode) {
+            case SIGNAL_OP_OPERAND: stack[++top] = operands[instruction.operand]; break;
+            case SIGNAL_OP_CONSTANT: stack[++top] = instruction.constant; break;
+            case SIGNAL_OP_EQ: top--; stack[top] = stack[top] == stack[top + 1]; break;
+            case SIGNAL_OP_NE: top--; stack[top] = stack[top] != stack[top + 1]; break;
+            case SIGNAL_OP_GT: top--; stack[top] = stack[top] > stack[top + 1]; break;
+            case SIGNAL_OP_GE: top--; stack[top] = stack[top] >= stack[top + 1]; break;
+            case SIGNAL_OP_LT: top--; stack[top] = stack[top] < stack[top + 1]; break;
+            case SIGNAL_OP_LE: top--; stack[top] = stack[top] <= stack[top + 1]; break;
+            case SIGNAL_OP_AND: top--; stack[top] = stack[top] != 0 && stack[top + 1] != 0; break;
+            case SIGNAL_OP_OR: top--; stack[top] = stack[top] != 0 || stack[top + 1] != 0; break;
+            case SIGNAL_OP_NOT: stack[top] = stack[top] == 0; break;
+        }
+    }
+
+    return top >= 0 && stack[top] != 0;
+}
+
+/* Evaluates the program over the bars [begin, begin + count), writing 1 or 0 into result.
+ * The program is interpreted one instruction at a time over the whole block,
+ * so the dispatch cost is paid once per block rather than once per bar,
+ * and each instruction's loop is simple enough for the compiler to vectorize.
+ * ArrayT is anything indexable by bar, such as SCFloatArray or const float*.
+ */
+template<typename ArrayT>
+void EvaluateSignalBlock(const SignalProgram& program, const ArrayT* operands, int begin, int count, float* result) {
+    float stack[SIGNAL_MAX_STACK_DEPTH][SIGNAL_BLOCK_SIZE];
+
+    // A program which failed to compile is never true.
+    if(program.length == 0) {
+        for(int k = 0; k < count; k++) result[k] = 0;
+        return;
+    }
+
+    for(int blockStart = 0; blockStart < count; blockStart += SIGNAL_BLOCK_SIZE) {
+        const int n = count - blockStart < SIGNAL_BLOCK_SIZE ? count - blockStart : SIGNAL_BLOCK_SIZE;
+        const int first = begin + blockStart;
+        int top = -1;
+
+        for(int pc = 0; pc < program.length; pc++) {
+            const SignalInstruction& instruction = program.code[pc];
+
+            if(instruction.opcode == SIGNAL_OP_OPERAND) {
+                const ArrayT& values = operands[instruction.operand];
+                float* out = stack[++top];
+                for(int k = 0; k < n; k++) out[k] = values[first + k];
+                continue;
+            }
+
+            if(instruction.opcode == SIGNAL_OP_CONSTANT) {
+                float* out = stack[++top];
+                for(int k = 0; k < n; k++) out[k] = instruction.constant;
+                continue;
+            }
+
+            if(instruction.opcode == SIGNAL_OP_NOT) {
+                float* a = stack[top];
+                for(int k = 0; k < n; k++) a[k] = a[k] == 0 ? 1.0f : 0.0f;
+                continue;
+            }
+
+            top--;
+            float* a = stack[top];
+            const float* b = stack[top + 1];
+
+            switch(instruction.opcode) {
+                case SIGNAL_OP_EQ: for(int k = 0; k < n; k++) a[k] = a[k] == b[k] ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_NE: for(int k = 0; k < n; k++) a[k] = a[k] != b[k] ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_GT: for(int k = 0; k < n; k++) a[k] = a[k] > b[k] ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_GE: for(int k = 0; k < n; k++) a[k] = a[k] >= b[k] ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_LT: for(int k = 0; k < n; k++) a[k] = a[k] < b[k] ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_LE: for(int k = 0; k < n; k++) a[k] = a[k] <= b[k] ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_AND: for(int k = 0; k < n; k++) a[k] = (a[k] != 0) & (b[k] != 0) ? 1.0f : 0.0f; break;
+                case SIGNAL_OP_OR: for(int k = 0; k < n; k++) a[k] = (a[k] != 0) | (b[k] != 0) ? 1.0f : 0.0f; break;
+            }
+        }
+
+        const float* value = stack[top];
+        for(int k = 0; k < n; k++) result[blockStart + k] = value[k] != 0 ? 1.0f : 0.0f;
+    }
+}
+
+#endif
@@ -0,0 +1,128 @@
+/* SignalInputs.h
+
+   Sierra Chart glue for SignalExpression.h: sets up the signal inputs, compiles the signal expression
+   once per full recalculation, and fetches only the subgraphs the expression refers to.
+
+   Include this after sierrachart.h.
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#ifndef SIGNAL_INPUTS_H
+#define SIGNAL_INPUTS_H
+
+#include "SignalExpression.h"
+
+/* The input indexes used by a study for its signal.
+ * operandInputs[0] is the study's original signal input, so that existing chart settings keep working.
+ */
+struct SignalInputIndexes {
+    int operandInputs[SIGNAL_OPERAND_COUNT];
+    int expressionInput;
+};
+
+inline void SetSignalInputDefaults(SCStudyInterfaceRef sc, const SignalInputIndexes& indexes) {
+    for(int i = 0; i < SIGNAL_OPERAND_COUNT; i++) {
+        SCInputRef input = sc.Input[indexes.operandInputs[i]];
+
+        input.Name.Format("Input signal (%c)", 'A' + i);
+        input.SetChartStudySubgraphValues(1, 1, 0);
+    }
+
+    SCInputRef expression = sc.Input[indexes.expressionInput];
+    expression.Name = "Signal expression, such as A > B && C != 0 (blank = A is non-zero)";
+    expression.SetString("");
+}
+
+/* Returns the compiled signal expression, compiling it at the start of a full recalculation.
+ * Since changing an input triggers a full recalculation, the expression is never stale.
+ * The program is kept in the persistent pointer at pointerIndex, and must be released with ReleaseSignalProgram().
+ */
+inline const SignalProgram& GetSignalProgram(SCStudyInterfaceRef sc, const SignalInputIndexes& indexes, int pointerIndex) {
+    void*& pointer = sc.GetPersistentPointer(pointerIndex);
+    bool compile = sc.Index == 0;
+
+    if(pointer == NULL) {
+        pointer = new SignalProgram();
+        compile = true;
+    }
+
+    SignalProgram& program = *static_cast<SignalProgram*>(pointer);
+
+    if(compile) {
+        if(!CompileSignalExpression(sc.Input[indexes.expressionInput].GetString(), program)) {
+            SCString msg;
+
+            msg.Format("ERROR: Unable to compile the signal expression, at character %d.", program.errorPosition + 1);
+            sc.AddMessageToLog(msg, 1);
+        }
+    }
+
+    return program;
+}
+
+inline void ReleaseSignalProgram(SCStudyInterfaceRef sc, int pointerIndex) {
+    void*& pointer = sc.GetPersistentPointer(pointerIndex);
+
+    if(pointer != NULL) {
+        delete static_cast<SignalProgram*>(pointer);
+        pointer = NULL;
+    }
+}
+
+// Fetches the subgraph arrays referenced by the program. The others are left empty.
+inline void GetSignalOperands(SCStudyInterfaceRef sc, const SignalInputIndexes& indexes, const SignalProgram& program, SCFloatArray* operands) {
+    for(int i = 0; i < SIGNAL_OPERAND_COUNT; i++) {
+        if(program.operandMask & (1u << i)) {
+            sc.GetStudyArrayFromChartUsingID(sc.Input[indexes.operandInputs[i]].GetChartStudySubgraphValues(), operands[i]);
+        }
+    }
+}
+
+inline bool EvaluateSignalAt(const SignalProgram& program, const SCFloatArray* operands, int index) {
+    float values[SIGNAL_OPERAND_COUNT] = { 0 };
+
+    for(int i = 0; i < SIGNAL_OPERAND_COUNT; i++) {
+        if(program.operandMask & (1u << i)) values[i] = operands[i][index];
+    }
+
+    return EvaluateSignal(program, values);
+}
+
+/* Presents the signal as an array of 1's and 0's, evaluated on demand,
+ * so that it can be passed to the kernels in StudyKernels.h.
+ */
+class SignalArray {
+public:
+    SignalArray(const SignalProgram& program, const SCFloatArray* operands) : program(program), operands(operands) {}
+
+    float operator[](int index) const {
+        return EvaluateSignalAt(program, operands, index) ? 1.0f : 0.0f;
+    }
+
+private:
+    const SignalProgram& program;
+    const SCFloatArray* operands;
+};
+
+#endif
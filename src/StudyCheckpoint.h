@@ -0,0 +1,197 @@
+/* StudyCheckpoint.h
+
+   Versioned on-disk checkpoints, so that a study can carry its state across chart reloads instead of rebuilding it.
+
+   A checkpoint is a small file made of a header and a study-defined payload. The header holds a fingerprint of
+   everything the payload depends on (symbol, chart, study ID, bar period, inputs, and the payload's own version), and the bar date-time
+   the checkpoint was taken at. A checkpoint is only used when the fingerprint matches, and when that date-time is
+   still a bar in the chart's data. Anything else, including a partially written file, reads as no checkpoint.
+
+   Include this after sierrachart.h.
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#ifndef STUDY_CHECKPOINT_H
+#define STUDY_CHECKPOINT_H
+
+const unsigned int STUDY_CHECKPOINT_VERSION = 1;
+
+struct StudyCheckpointHeader {
+    char magic[4]; // "SCKP"
+    unsigned int version;
+    unsigned int payloadSize;
+    unsigned int reserved;
+    unsigned long long fingerprint;
+    double dateTime;
+};
+
+// A 64-bit FNV-1a hash, built up from the values a checkpoint depends on.
+class StudyFingerprint {
+public:
+    StudyFingerprint() : hash(14695981039346656037ULL) {}
+
+    StudyFingerprint& Add(const void* data, unsigned int size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+        for(unsigned int i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+
+        return *this;
+    }
+
+    StudyFingerprint& Add(int value) {
+        return Add(&value, sizeof(value));
+    }
+
+    StudyFingerprint& Add(const char* text) {
+        // Include the terminator, so that "ab" + "c" differs from "a" + "bc".
+        return Add(text, (unsigned int)strlen(text) + 1);
+    }
+
+    StudyFingerprint& Add(const s_ChartStudySubgraphValues& values) {
+        return Add(values.ChartNumber).Add(values.StudyID).Add(values.SubgraphIndex);
+    }
+
+    unsigned long long Value() const {
+        return hash;
+    }
+
+private:
+    unsigned long long hash;
+};
+
+/* The fingerprint every checkpoint starts from: the symbol, the chart and study, and the chart's full bar period.
+ * Study IDs restart at 1 on every chart, so the chart number is needed too.
+ * The whole bar period is used, rather than sc.SecondsPerBar, which is 0 for every tick, volume, and range chart.
+ */
+inline StudyFingerprint BeginStudyFingerprint(SCStudyInterfaceRef sc, int payloadVersion) {
+    StudyFingerprint fingerprint;
+    n_ACSIL::s_BarPeriod barPeriod;
+
+    sc.GetBarPeriodParameters(barPeriod);
+
+    fingerprint.Add(STUDY_CHECKPOINT_VERSION).Add(payloadVersion);
+    fingerprint.Add(sc.Symbol.GetChars()).Add(sc.ChartNumber).Add(sc.StudyGraphInstanceID);
+    fingerprint.Add((int)barPeriod.ChartDataType).Add((int)barPeriod.HistoricalChartBarPeriodType).Add((int)barPeriod.HistoricalChartDaysPerBar);
+    fingerprint.Add((int)barPeriod.IntradayChartBarPeriodType).Add((int)barPeriod.IntradayChartBarPeriodParameter1);
+    fingerprint.Add((int)barPeriod.IntradayChartBarPeriodParameter2).Add((int)barPeriod.IntradayChartBarPeriodParameter3).Add((int)barPeriod.IntradayChartBarPeriodParameter4);
+    return fingerprint;
+}
+
+// <Data Files Folder>\<symbol>-<chart number>-<study ID>-<name>.checkpoint, with any character not safe in a file name replaced.
+inline SCString StudyCheckpointPath(SCStudyInterfaceRef sc, const char* name) {
+    const char* symbol = sc.Symbol.GetChars();
+    SCString path = sc.DataFilesFolder();
+
+    if(path.GetLength() > 0 && path.GetChars()[path.GetLength() - 1] != '\\') path.Append("\\");
+    for(int i = 0; symbol[i] != '\0'; i++) {
+        const char c = symbol[i];
+        const bool safe = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+
+        path.AppendFormat("%c", safe ? c : '_');
+    }
+
+    path.AppendFormat("-%d-%d-%s.checkpoint", sc.ChartNumber, sc.StudyGraphInstanceID, name);
+    return path;
+}
+
+/* Returns false if the checkpoint couldn't be written. Nothing is logged,
+ * since a study may write its checkpoint often, and is better placed to decide how to report the failure.
+ */
+inline bool WriteStudyCheckpoint(SCStudyInterfaceRef sc, const SCString& path, const StudyFingerprint& fingerprint, const SCDateTime& dateTime, const void* payload, unsigned int payloadSize) {
+    StudyCheckpointHeader header;
+    unsigned int bytesWritten = 0;
+    int fileHandle = 0;
+
+    header.magic[0] = 'S';
+    header.magic[1] = 'C';
+    header.magic[2] = 'K';
+    header.magic[3] = 'P';
+    header.version = STUDY_CHECKPOINT_VERSION;
+    header.payloadSize = payloadSize;
+    header.reserved = 0;
+    header.fingerprint = fingerprint.Value();
+    header.dateTime = dateTime.GetAsDouble();
+
+    if(!sc.OpenFile(path, n_ACSIL::FILE_MODE_OPEN_TO_REWRITE_FROM_START, fileHandle)) return false;
+
+    bool written = sc.WriteFile(fileHandle, reinterpret_cast<const char*>(&header), sizeof(header), &bytesWritten) && bytesWritten == sizeof(header);
+    if(written && payloadSize > 0) {
+        written = sc.WriteFile(fileHandle, static_cast<const char*>(payload), payloadSize, &bytesWritten) && bytesWritten == payloadSize;
+    }
+
+    sc.CloseFile(fileHandle);
+
+    return written;
+}
+
+/* Reads the checkpoint into payload, and the date-time it was taken at into dateTime.
+ * Returns false when there's no checkpoint, or it doesn't match the fingerprint.
+ */
+inline bool ReadStudyCheckpointFile(SCStudyInterfaceRef sc, const SCString& path, const StudyFingerprint& fingerprint, SCDateTime& dateTime, void* payload, unsigned int payloadSize) {
+    StudyCheckpointHeader header;
+    unsigned int bytesRead = 0;
+    int fileHandle = 0;
+
+    // A missing checkpoint is normal, for example the first time the study runs.
+    if(!sc.OpenFile(path, n_ACSIL::FILE_MODE_OPEN_EXISTING_FOR_SEQUENTIAL_READING, fileHandle)) return false;
+
+    bool valid = sc.ReadFile(fileHandle, reinterpret_cast<char*>(&header), sizeof(header), &bytesRead) && bytesRead == sizeof(header)
+        && header.magic[0] == 'S' && header.magic[1] == 'C' && header.magic[2] == 'K' && header.magic[3] == 'P'
+        && header.version == STUDY_CHECKPOINT_VERSION
+        && header.payloadSize == payloadSize
+        && header.fingerprint == fingerprint.Value();
+
+    if(valid && payloadSize > 0) {
+        valid = sc.ReadFile(fileHandle, static_cast<char*>(payload), payloadSize, &bytesRead) && bytesRead == payloadSize;
+    }
+
+    sc.CloseFile(fileHandle);
+
+    if(valid) dateTime = SCDateTime(header.dateTime);
+    return valid;
+}
+
+/* Reads the checkpoint into payload, and returns the index of the bar it was taken at,
+ * or -1 when there's no usable checkpoint.
+ */
+inline int ReadStudyCheckpoint(SCStudyInterfaceRef sc, const SCString& path, const StudyFingerprint& fingerprint, void* payload, unsigned int payloadSize) {
+    SCDateTime dateTime;
+
+    if(!ReadStudyCheckpointFile(sc, path, fingerprint, dateTime, payload, payloadSize)) return -1;
+
+    /* The checkpoint's bar must still be in the chart, at the same date-time.
+     * If the data file was replaced, trimmed, or now ends before the checkpoint, the checkpoint is stale.
+     */
+    if(sc.ArraySize == 0 || dateTime > sc.BaseDateTimeIn[sc.ArraySize - 1]) return -1;
+
+    const int index = sc.GetContainingIndexForSCDateTime(sc.ChartNumber, dateTime);
+    if(index < 0 || index >= sc.ArraySize || sc.BaseDateTimeIn[index].GetAsDouble() != dateTime.GetAsDouble()) return -1;
+
+    return index;
+}
+
+#endif
@@ -0,0 +1,176 @@
+/* StudyKernels.h
+
+   The per-bar logic of the counting studies, written as small functors which don't depend on sierrachart.h,
+   so that the studies and the batch tools (see tools/ScidBatch.cpp) run exactly the same code.
+
+   The kernels are templates over the array types they read, so that they work with both Sierra Chart's arrays
+   and plain pointers, and inline into the caller's loop. Configuration which would otherwise be branched on for every bar,
+   such as the duration unit, is a template parameter instead. The caller selects the specialization once, per calculation.
+
+   The kernels keep their state in variables owned by the caller, such as a study's persistent variables,
+   so that the state survives between calls.
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#ifndef STUDY_KERNELS_H
+#define STUDY_KERNELS_H
+
+enum DurationUnitEnum {
+    DURATION_HOURS
+    , DURATION_MINUTES
+    , DURATION_SECONDS
+};
+
+/* Builds a duration of the given unit, using TimeTraits to create the caller's date-time type.
+ * TimeTraits provides: typedef Type, and static Type Hours(unsigned int), Minutes(unsigned int) and Seconds(unsigned int).
+ */
+template<DurationUnitEnum Unit> struct DurationUnit;
+
+template<> struct DurationUnit<DURATION_HOURS> {
+    template<typename TimeTraits> static typename TimeTraits::Type Make(unsigned int value) { return TimeTraits::Hours(value); }
+};
+
+template<> struct DurationUnit<DURATION_MINUTES> {
+    template<typename TimeTraits> static typename TimeTraits::Type Make(unsigned int value) { return TimeTraits::Minutes(value); }
+};
+
+template<> struct DurationUnit<DURATION_SECONDS> {
+    template<typename TimeTraits> static typename TimeTraits::Type Make(unsigned int value) { return TimeTraits::Seconds(value); }
+};
+
+/* Counts the number of bars within the duration. See BarCountPerDuration.cpp for how the window works.
+ * endDateTime and startTimeBarIndex are the window's state.
+ */
+template<typename TimeTraits, DurationUnitEnum Unit>
+class BarCountPerDurationKernel {
+public:
+    typedef typename TimeTraits::Type TimeT;
+
+    BarCountPerDurationKernel(unsigned int durationValue, TimeT& endDateTime, int& startTimeBarIndex)
+        : duration(DurationUnit<Unit>::template Make<TimeTraits>(durationValue)), endDateTime(endDateTime), startTimeBarIndex(startTimeBarIndex) {}
+
+    // Places both ends of the window at the first bar.
+    void Start(const TimeT& firstBarStartDateTime) {
+        endDateTime = firstBarStartDateTime + duration;
+        startTimeBarIndex = 0;
+    }
+
+    // Returns the bar count for the bar at index, which must come after the bars already seen.
+    template<typename DateTimeArrayT>
+    int operator()(const DateTimeArrayT& barEndDateTimes, int index) {
+        const TimeT barEndDateTime = barEndDateTimes[index];
+
+        if(barEndDateTime > endDateTime) {
+            const TimeT startDateTime = barEndDateTime - duration;
+            endDateTime = barEndDateTime;
+
+            // Once a bar falls within the duration window, then there's no reason to keep looking.
+            while(startTimeBarIndex < index && barEndDateTimes[startTimeBarIndex] < startDateTime) startTimeBarIndex++;
+        }
+
+        return index - startTimeBarIndex + 1;
+    }
+
+    const TimeT& Duration() const {
+        return duration;
+    }
+
+private:
+    const TimeT duration;
+    TimeT& endDateTime;
+    int& startTimeBarIndex;
+};
+
+/* Counts the number of bars with a non-zero signal, over the last length bars.
+ * priorCount is the count over the length - 1 bars before the current one.
+ * Advance() slides the window by one bar in O(1), which is only exact if a bar's signal never changes once it's in the window.
+ * That holds for a fixed series, such as in scid-batch. A study's signal may be repainted,
+ * so scsf_SignalCountPerNumberOfBars recounts priorCount itself instead.
+ */
+class SignalCountKernel {
+public:
+    SignalCountKernel(int length, int& priorCount) : length(length), priorCount(priorCount) {}
+
+    // Call once when index becomes the current bar, that is once the bar before it is final.
+    template<typename SignalArrayT>
+    void Advance(const SignalArrayT& signal, int index) {
+        if(index == 0) {
+            priorCount = 0;
+            return;
+        }
+
+        if(signal[index - 1] != 0) priorCount++;
+        if(index - length >= 0 && signal[index - length] != 0) priorCount--;
+    }
+
+    // Whether there are enough bars for a full window.
+    bool IsReady(int index) const {
+        return index + 1 >= length;
+    }
+
+    template<typename SignalArrayT>
+    int operator()(const SignalArrayT& signal, int index) const {
+        return signal[index] != 0 ? priorCount + 1 : priorCount;
+    }
+
+private:
+    const int length;
+    int& priorCount;
+};
+
+/* The number of consecutive bars, up to and including the current one, with a non-zero signal.
+ * priorCount is the value at the bar before.
+ */
+struct BarCountDuringSignalKernel {
+    float operator()(float priorCount, bool signal) const {
+        return signal ? priorCount + 1 : 0;
+    }
+};
+
+/* Records the length of each run of non-zero signal, at the bar where the signal drops to zero.
+ * lastCount is the length of the run in progress.
+ */
+class HighestBarCountDuringSignalKernel {
+public:
+    explicit HighestBarCountDuringSignalKernel(int& lastCount) : lastCount(lastCount) {}
+
+    /* Call once per bar, once that bar is final.
+     * Returns true, with the count to record at that bar, when the bar ends a run.
+     */
+    bool operator()(bool signal, int& recordedCount) {
+        if(!signal) {
+            recordedCount = lastCount;
+            lastCount = 0;
+            return true;
+        }
+
+        lastCount++;
+        return false;
+    }
+
+private:
+    int& lastCount;
+};
+
+#endif
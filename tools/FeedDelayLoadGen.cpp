@@ -0,0 +1,297 @@
+/* FeedDelayLoadGen.cpp
+
+   A load generator for the data feed delay studies (DataFeedDelay.cpp), which runs offline, without Sierra Chart.
+   It replays the synthetic delay patterns of DataFeedDelayKernels.h against a simulated clock, at a fixed update rate,
+   through the same delay computation and alert state machine as scsf_DataFeedDelayAlertStudy, including the session gating and the snooze.
+
+   For each pattern it reports:
+       - The processing cost per update, measured on a pass which only runs the study's logic.
+       - The delay episodes: the spans during which the feed's true (unrounded) delay exceeds the threshold.
+         An episode ends once the true delay is back a whole second under the threshold,
+         so that the sub-second jitter of the feed's updates doesn't split an episode in two.
+         Episodes which begin outside of the session are reported as gated.
+       - The alert latency: from the start of an episode until its first alert, in simulated seconds.
+       - Spurious alerts, which fire outside of an episode. There should be none.
+
+   Build on Linux with:
+       g++ -O2 -std=c++11 -o feed-delay-loadgen tools/FeedDelayLoadGen.cpp
+
+   Usage:
+       feed-delay-loadgen [-p pattern] [-r updates per second] [-T seconds] [-t threshold] [-z snooze seconds]
+                          [-b HH:MM] [-S HH:MM-HH:MM]
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "../src/DataFeedDelayKernels.h"
+
+const double SECONDS_PER_DAY = 86400.0;
+
+const char* const PATTERN_NAMES[] = { "spikes", "drift", "flapping" };
+const int PATTERN_COUNT = 3;
+
+struct Options {
+    double updatesPerSecond;
+    double seconds;
+    int threshold;
+    int snoozeLength; // In seconds. Zero disables the snooze.
+    double beginTime; // Time of day, in seconds.
+    double sessionOpen;
+    double sessionClose;
+};
+
+struct Report {
+    int64_t updates;
+    double nanosecondsPerUpdate;
+    int episodes;
+    int gatedEpisodes;
+    int alertedEpisodes;
+    int alerts;
+    int spuriousAlerts;
+    int snoozes;
+    double totalLatency;
+    double maxLatency;
+};
+
+inline bool IsInSession(const Options& options, double clock) {
+    const double timeOfDay = fmod(clock, SECONDS_PER_DAY);
+    return timeOfDay >= options.sessionOpen && timeOfDay < options.sessionClose;
+}
+
+// Discards the events, for the timed pass.
+struct NullObserver {
+    unsigned int checksum;
+
+    NullObserver() : checksum(0) {}
+
+    void operator()(double, double, bool, int events) {
+        checksum += events;
+    }
+};
+
+// Matches the alerts to the delay episodes.
+struct LatencyObserver {
+    const Options& options;
+    Report& report;
+    bool inEpisode;
+    bool episodeAlerted;
+    double episodeStart;
+
+    LatencyObserver(const Options& options, Report& report) : options(options), report(report), inEpisode(false), episodeAlerted(false), episodeStart(0) {}
+
+    void operator()(double clock, double lastBidAskUpdateTime, bool inSession, int events) {
+        const double trueDelay = clock - lastBidAskUpdateTime;
+        const bool isDelayed = trueDelay > options.threshold;
+
+        if(isDelayed && !inEpisode) {
+            inEpisode = true;
+            episodeAlerted = false;
+            episodeStart = clock;
+            report.episodes++;
+            if(!inSession) report.gatedEpisodes++;
+        }
+
+        if(events & FEED_DELAY_ALERT) {
+            report.alerts++;
+
+            if(!inEpisode) {
+                report.spuriousAlerts++;
+            } else if(!episodeAlerted) {
+                const double latency = clock - episodeStart;
+
+                episodeAlerted = true;
+                report.alertedEpisodes++;
+                report.totalLatency += latency;
+                report.maxLatency = std::max(report.maxLatency, latency);
+            }
+        }
+
+        if(events & FEED_DELAY_SNOOZE_STARTED) report.snoozes++;
+        if(trueDelay <= options.threshold - 1) inEpisode = false;
+    }
+};
+
+/* Replays the pattern through the study's logic, one update at a time, and passes each update's outcome to the observer.
+ * When a snooze length is given, the simulated user snoozes the alert once, on the update after the first alert.
+ */
+template<typename ObserverT>
+void Replay(const Options& options, SyntheticFeedPatternEnum pattern, ObserverT& observer) {
+    const int64_t updates = (int64_t)(options.seconds * options.updatesPerSecond);
+    int allowAlert = true;
+    int isSnoozed = false;
+    double snoozeEndDateTime = 0;
+    DataFeedDelayAlertKernel<double> alert(allowAlert, isSnoozed, snoozeEndDateTime);
+    bool snoozeRequested = false;
+    bool snoozeUsed = options.snoozeLength == 0;
+
+    alert.Reset();
+
+    for(int64_t i = 0; i < updates; i++) {
+        const double clock = options.beginTime + i / options.updatesPerSecond;
+        const double lastBidAskUpdateTime = SyntheticBidAskUpdateTime(pattern, options.threshold, clock);
+        const int delay = FeedDelaySeconds(clock, lastBidAskUpdateTime);
+        const bool inSession = IsInSession(options, clock);
+        const int events = alert((float)delay, options.threshold, inSession, clock, (double)options.snoozeLength, snoozeRequested, false);
+
+        if(snoozeRequested) {
+            snoozeRequested = false;
+            snoozeUsed = true;
+        }
+
+        if((events & FEED_DELAY_ALERT) && !snoozeUsed) snoozeRequested = true;
+
+        observer(clock, lastBidAskUpdateTime, inSession, events);
+    }
+}
+
+Report RunPattern(const Options& options, SyntheticFeedPatternEnum pattern) {
+    Report report;
+    NullObserver nullObserver;
+    LatencyObserver latencyObserver(options, report);
+
+    memset(&report, 0, sizeof(report));
+    report.updates = (int64_t)(options.seconds * options.updatesPerSecond);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Replay(options, pattern, nullObserver);
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    if(report.updates > 0) report.nanosecondsPerUpdate = std::chrono::duration<double, std::nano>(end - start).count() / report.updates;
+
+    // Keeps the timed pass from being optimized away.
+    if(nullObserver.checksum == 0xFFFFFFFFu) fputc('\n', stderr);
+
+    Replay(options, pattern, latencyObserver);
+    return report;
+}
+
+void PrintReport(const char* patternName, const Report& report) {
+    printf("%-10s %12lld %10.1f %14.0f %9d %6d %8d %7d %9d %8d %13.3f %12.3f\n"
+        , patternName
+        , (long long)report.updates
+        , report.nanosecondsPerUpdate
+        , report.nanosecondsPerUpdate > 0 ? 1e9 / report.nanosecondsPerUpdate : 0.0
+        , report.episodes
+        , report.gatedEpisodes
+        , report.alertedEpisodes
+        , report.alerts
+        , report.spuriousAlerts
+        , report.snoozes
+        , report.alertedEpisodes > 0 ? report.totalLatency / report.alertedEpisodes : 0.0
+        , report.maxLatency);
+}
+
+// Parses HH:MM into seconds since midnight. 24:00 is allowed, as the end of the day.
+bool ParseTimeOfDay(const char* text, double& seconds) {
+    int hours = 0;
+    int minutes = 0;
+
+    if(sscanf(text, "%d:%d", &hours, &minutes) != 2 || hours < 0 || minutes < 0 || minutes > 59 || hours * 60 + minutes > 24 * 60) return false;
+
+    seconds = hours * 3600.0 + minutes * 60.0;
+    return true;
+}
+
+bool ParseSession(const char* text, double& open, double& close) {
+    const char* separator = strchr(text, '-');
+
+    return separator != NULL && ParseTimeOfDay(text, open) && ParseTimeOfDay(separator + 1, close) && open < close;
+}
+
+void PrintUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -p PATTERN     spikes, drift, flapping, or all (default all).\n"
+        "  -r RATE        Updates per second (default 5000).\n"
+        "  -T SECONDS     Simulated length of each run (default 3600).\n"
+        "  -t SECONDS     Data feed delay threshold (default 10).\n"
+        "  -z SECONDS     Snooze the first alert for this long (default 0, no snooze).\n"
+        "  -b HH:MM       Simulated start time (default 09:00).\n"
+        "  -S HH:MM-HH:MM Session to monitor (default 00:00-24:00).\n"
+        , program);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    int pattern = -1;
+    int option;
+
+    options.updatesPerSecond = 5000;
+    options.seconds = 3600;
+    options.threshold = 10;
+    options.snoozeLength = 0;
+    options.beginTime = 9 * 3600.0;
+    options.sessionOpen = 0;
+    options.sessionClose = SECONDS_PER_DAY;
+
+    while((option = getopt(argc, argv, "p:r:T:t:z:b:S:h")) != -1) {
+        switch(option) {
+            case 'p':
+                pattern = -2;
+                if(strcmp(optarg, "all") == 0) pattern = -1;
+                for(int i = 0; i < PATTERN_COUNT; i++) {
+                    if(strcmp(optarg, PATTERN_NAMES[i]) == 0) pattern = i;
+                }
+                break;
+            case 'r': options.updatesPerSecond = atof(optarg); break;
+            case 'T': options.seconds = atof(optarg); break;
+            case 't': options.threshold = atoi(optarg); break;
+            case 'z': options.snoozeLength = atoi(optarg); break;
+            case 'b':
+                if(!ParseTimeOfDay(optarg, options.beginTime)) pattern = -2;
+                break;
+            case 'S':
+                if(!ParseSession(optarg, options.sessionOpen, options.sessionClose)) pattern = -2;
+                break;
+            default:
+                PrintUsage(argv[0]);
+                return 2;
+        }
+    }
+
+    if(optind != argc || pattern == -2 || options.updatesPerSecond <= 0 || options.seconds <= 0 || options.threshold < 1 || options.snoozeLength < 0) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    printf("%-10s %12s %10s %14s %9s %6s %8s %7s %9s %8s %13s %12s\n"
+        , "pattern", "updates", "ns/update", "max updates/s", "episodes", "gated", "alerted", "alerts", "spurious", "snoozes", "mean latency", "max latency");
+
+    for(int i = 0; i < PATTERN_COUNT; i++) {
+        if(pattern >= 0 && pattern != i) continue;
+
+        PrintReport(PATTERN_NAMES[i], RunPattern(options, static_cast<SyntheticFeedPatternEnum>(i)));
+    }
+
+    return 0;
+}
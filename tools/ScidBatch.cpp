@@ -0,0 +1,744 @@
+/* ScidBatch.cpp
+
+   A command-line tool which runs the counting studies over Sierra Chart intraday (.scid) files, without opening charts.
+   Each .scid file is memory-mapped and read in place, one sequential pass, to build bars of the requested timeframe.
+   The studies are then computed over those bars, and the results are written to a CSV file per symbol,
+   using the same column layout as ExportToCSV.cpp with the "Subgraph name" header format.
+
+   Unlike a chart, the tool doesn't apply a time zone: the bars are aligned to the timeframe from midnight UTC,
+   and the date-times are written in UTC, as they are stored in the .scid file.
+
+   The columns are:
+       Bar count per duration            (BarCountPerDuration.cpp)
+       Signal count, Signal percentage   (SignalCountPerNumberOfBars.cpp)
+       Bar count during signal           (BarCountDuringSignal.cpp)
+       Highest bar count during signal   (HighestBarCountDuringSignal.cpp)
+
+   The signal is a SignalExpression.h expression, where A = close, B = open, C = volume, and D = number of trades.
+   For example, the default "A > B" counts up bars.
+
+   The files are processed in parallel, on a work-stealing scheduler (WorkStealingScheduler.h).
+   A long series is also split into time chunks, both to build its bars and to compute the studies.
+   Each chunk reads the bars it depends on from before its start (the duration window, or the signal length),
+   and the run-length studies are stitched across chunks afterwards, so the output is identical to a sequential run.
+
+   Build on Linux with:
+       g++ -O2 -std=c++11 -pthread -o scid-batch tools/ScidBatch.cpp
+
+   Usage:
+       scid-batch [-t timeframe seconds] [-d duration seconds] [-l length] [-s signal] [-o output directory]
+                  [-j threads] [-c records per chunk] file.scid...
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/SignalExpression.h"
+#include "../src/StudyKernels.h"
+#include "WorkStealingScheduler.h"
+
+using std::max;
+
+const int64_t MICROSECONDS_PER_SECOND = 1000000;
+const int64_t MICROSECONDS_PER_DAY = 86400 * MICROSECONDS_PER_SECOND;
+const int64_t SCDATETIME_UNIX_EPOCH_DAYS = 25569; // 1970-01-01, counted from SCDateTime's epoch of 1899-12-30.
+
+// The markers Sierra Chart stores in the Open field of a tick record, instead of a price.
+const float SINGLE_TRADE_WITH_BID_ASK = 0.0f;
+const float FIRST_SUB_TRADE_OF_UNBUNDLED_TRADE = -1.99900095e37f;
+const float LAST_SUB_TRADE_OF_UNBUNDLED_TRADE = -1.99900197e37f;
+
+/* The .scid file format, as documented by Sierra Chart in "Intraday Data File Format".
+ * The file is a header followed by fixed-size records.
+ */
+struct ScidHeader {
+    char fileTypeUniqueHeaderID[4]; // "SCID"
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint16_t version;
+    uint16_t unused1;
+    uint32_t utcStartIndex;
+    char reserve[36];
+};
+
+struct ScidRecord {
+    int64_t dateTime; // Microseconds since 1899-12-30 UTC. Older files store a double of days instead.
+    float open;
+    float high;
+    float low;
+    float close;
+    uint32_t numTrades;
+    uint32_t totalVolume;
+    uint32_t bidVolume;
+    uint32_t askVolume;
+};
+
+static_assert(sizeof(ScidHeader) == 56, "The .scid header must be 56 bytes.");
+static_assert(sizeof(ScidRecord) == 40, "The .scid record must be 40 bytes.");
+
+/* A read-only memory mapping of a .scid file.
+ * The records are used in place; nothing is copied out of the mapping.
+ */
+class MappedScidFile {
+public:
+    MappedScidFile() : data(NULL), size(0), records(NULL), recordCount(0) {}
+
+    ~MappedScidFile() {
+        Close();
+    }
+
+    bool Open(const char* path, std::string& error) {
+        const int fd = open(path, O_RDONLY);
+        if(fd < 0) {
+            error = std::string("unable to open the file: ") + strerror(errno);
+            return false;
+        }
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ScidHeader)) {
+            error = "the file is too small to be a .scid file";
+            close(fd);
+            return false;
+        }
+
+        size = info.st_size;
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if(data == MAP_FAILED) {
+            data = NULL;
+            error = std::string("unable to map the file: ") + strerror(errno);
+            return false;
+        }
+
+        // The records are read once, front to back, so let the kernel read ahead aggressively.
+        madvise(data, size, MADV_SEQUENTIAL);
+        madvise(data, size, MADV_WILLNEED);
+
+        const ScidHeader* header = static_cast<const ScidHeader*>(data);
+
+        if(memcmp(header->fileTypeUniqueHeaderID, "SCID", 4) != 0) {
+            error = "missing the SCID header";
+            Close();
+            return false;
+        }
+
+        if(header->recordSize != sizeof(ScidRecord) || header->headerSize < sizeof(ScidHeader) || header->headerSize > size) {
+            error = "unsupported header or record size";
+            Close();
+            return false;
+        }
+
+        records = reinterpret_cast<const ScidRecord*>(static_cast<const char*>(data) + header->headerSize);
+        recordCount = (size - header->headerSize) / sizeof(ScidRecord);
+        return true;
+    }
+
+    // Unmaps the file. The records can't be used afterwards.
+    void Close() {
+        if(data != NULL) munmap(data, size);
+
+        data = NULL;
+        size = 0;
+        records = NULL;
+        recordCount = 0;
+    }
+
+    const ScidRecord* Records() const { return records; }
+    size_t RecordCount() const { return recordCount; }
+
+private:
+    void* data;
+    size_t size;
+    const ScidRecord* records;
+    size_t recordCount;
+
+    MappedScidFile(const MappedScidFile&);
+    MappedScidFile& operator=(const MappedScidFile&);
+};
+
+/* Bars in a structure-of-arrays layout, so that a signal expression can be evaluated over a column at a time.
+ * Times are microseconds since 1899-12-30 UTC.
+ */
+struct BarSeries {
+    std::vector<int64_t> startDateTime;
+    std::vector<int64_t> endDateTime;
+    std::vector<float> open;
+    std::vector<float> high;
+    std::vector<float> low;
+    std::vector<float> close;
+    std::vector<float> volume;
+    std::vector<float> numTrades;
+
+    size_t Size() const { return startDateTime.size(); }
+};
+
+struct StudyOutputs {
+    std::vector<float> barCountPerDuration;
+    std::vector<float> signalCount;
+    std::vector<float> signalPercentage;
+    std::vector<float> barCountDuringSignal;
+    std::vector<float> highestBarCountDuringSignal;
+};
+
+struct Options {
+    int64_t timeframe; // In microseconds.
+    unsigned int duration; // In seconds.
+    int length;
+    const char* signal;
+    const char* outputDirectory;
+    size_t recordsPerChunk;
+};
+
+/* Files written before SCDateTime became an integer store the date-time as a double of days.
+ * As an integer of microseconds, any date after 1900 is far larger than a plausible number of days,
+ * and as a double, an integer of microseconds is a tiny denormal, so the two can't be confused.
+ */
+bool IsLegacyDateTime(const ScidRecord* records, size_t count) {
+    if(count == 0) return false;
+
+    double days;
+    memcpy(&days, &records[0].dateTime, sizeof(days));
+    return days > 1.0 && days < 200000.0;
+}
+
+inline int64_t RecordDateTime(const ScidRecord& record, bool legacyDateTime) {
+    if(!legacyDateTime) return record.dateTime;
+
+    double days;
+    memcpy(&days, &record.dateTime, sizeof(days));
+    return (int64_t)(days * MICROSECONDS_PER_DAY + 0.5);
+}
+
+/* Builds time-based bars aligned to the timeframe, in one sequential pass over the records.
+ * Tick records carry the trade price in Close, and a marker in Open. Records which are already bars carry all four prices.
+ * A bar's end date-time is the date-time of its last record.
+ */
+void BuildBars(const ScidRecord* records, size_t count, int64_t timeframe, bool legacyDateTime, BarSeries& bars) {
+    int64_t barKey = INT64_MIN;
+
+    for(size_t i = 0; i < count; i++) {
+        const ScidRecord& record = records[i];
+        const int64_t dateTime = RecordDateTime(record, legacyDateTime);
+        const int64_t key = dateTime / timeframe;
+        const bool isTick = record.open == SINGLE_TRADE_WITH_BID_ASK
+            || record.open == FIRST_SUB_TRADE_OF_UNBUNDLED_TRADE
+            || record.open == LAST_SUB_TRADE_OF_UNBUNDLED_TRADE;
+        const float open = isTick ? record.close : record.open;
+        const float high = isTick ? record.close : record.high;
+        const float low = isTick ? record.close : record.low;
+
+        if(key != barKey) {
+            barKey = key;
+            bars.startDateTime.push_back(key * timeframe);
+            bars.endDateTime.push_back(dateTime);
+            bars.open.push_back(open);
+            bars.high.push_back(high);
+            bars.low.push_back(low);
+            bars.close.push_back(record.close);
+            bars.volume.push_back((float)record.totalVolume);
+            bars.numTrades.push_back((float)record.numTrades);
+            continue;
+        }
+
+        const size_t last = bars.Size() - 1;
+        bars.endDateTime[last] = dateTime;
+        if(high > bars.high[last]) bars.high[last] = high;
+        if(low < bars.low[last]) bars.low[last] = low;
+        bars.close[last] = record.close;
+        bars.volume[last] += (float)record.totalVolume;
+        bars.numTrades[last] += (float)record.numTrades;
+    }
+}
+
+/* The functions below run the kernels from StudyKernels.h over the bars [begin, end) of a series,
+ * so that a long series can be split into chunks.
+ * Anything a chunk needs from before begin is read from the overlap: the duration window, or the signal length.
+ * The signal arrays are indexed from signalBegin, that is signal[0] is the signal at bar signalBegin.
+ */
+
+// Date-times in microseconds, as stored in .scid files.
+struct MicrosecondTimeTraits {
+    typedef int64_t Type;
+
+    static Type Hours(unsigned int value) { return (Type)value * 3600 * MICROSECONDS_PER_SECOND; }
+    static Type Minutes(unsigned int value) { return (Type)value * 60 * MICROSECONDS_PER_SECOND; }
+    static Type Seconds(unsigned int value) { return (Type)value * MICROSECONDS_PER_SECOND; }
+};
+
+// Presents a signal array indexed from signalBegin as if it were indexed from the first bar.
+class OffsetSignalArray {
+public:
+    OffsetSignalArray(const float* signal, int signalBegin) : signal(signal), signalBegin(signalBegin) {}
+
+    float operator[](int index) const {
+        return signal[index - signalBegin];
+    }
+
+private:
+    const float* signal;
+    const int signalBegin;
+};
+
+/* Runs the kernel of scsf_BarCountPerDuration.
+ * The kernel's state at begin is recovered from the bars before it, which is exact because bar end date-times never decrease:
+ * the window end is the latest bar end seen so far, and the window start is the first bar within the duration of it.
+ */
+void ComputeBarCountPerDuration(const BarSeries& bars, unsigned int duration, int begin, int end, float* barCount) {
+    int64_t endDateTime = 0;
+    int startTimeBarIndex = 0;
+    BarCountPerDurationKernel<MicrosecondTimeTraits, DURATION_SECONDS> kernel(duration, endDateTime, startTimeBarIndex);
+
+    kernel.Start(bars.startDateTime[0]);
+    if(begin > 1 && bars.endDateTime[begin - 1] > endDateTime) {
+        endDateTime = bars.endDateTime[begin - 1];
+        startTimeBarIndex = (int)(std::lower_bound(bars.endDateTime.begin(), bars.endDateTime.begin() + begin, endDateTime - kernel.Duration()) - bars.endDateTime.begin());
+    }
+
+    for(int index = begin; index < end; index++) {
+        barCount[index] = index == 0 ? 0 : (float)kernel(bars.endDateTime, index);
+    }
+}
+
+/* Runs the kernel of scsf_SignalCountPerNumberOfBars.
+ * The signal must start at or before begin - length.
+ */
+void ComputeSignalCount(const float* signal, int signalBegin, int length, int begin, int end, float* count, float* percentage) {
+    const OffsetSignalArray signalArray(signal, signalBegin);
+    int priorCount = 0;
+    SignalCountKernel kernel(length, priorCount);
+
+    // The count over the length - 1 bars before begin, as the kernel would have left it.
+    for(int index = max(0, begin - length + 1); index < begin; index++) {
+        if(signalArray[index] != 0) priorCount++;
+    }
+
+    for(int index = begin; index < end; index++) {
+        if(index > begin) kernel.Advance(signalArray, index);
+
+        if(!kernel.IsReady(index)) {
+            count[index] = 0;
+            percentage[index] = 0;
+            continue;
+        }
+
+        const int windowCount = kernel(signalArray, index);
+        count[index] = (float)windowCount;
+        percentage[index] = (float)windowCount / (float)length;
+    }
+}
+
+/* Runs the kernel of scsf_TemplateFunction in BarCountDuringSignal.cpp.
+ * A run of signal which started before begin is added by StitchRunLengths().
+ */
+void ComputeBarCountDuringSignal(const float* signal, int signalBegin, int begin, int end, float* count) {
+    const BarCountDuringSignalKernel kernel;
+    float runLength = 0;
+
+    for(int index = begin; index < end; index++) {
+        runLength = kernel(runLength, signal[index - signalBegin] != 0);
+        count[index] = runLength;
+    }
+}
+
+/* Runs the kernel of scsf_HighestBarCountDuringSignal.
+ * The study records a bar's value once the next bar opens, so the last bar of the series (size - 1) is left at zero.
+ * A run of signal which started before begin is added by StitchRunLengths().
+ */
+void ComputeHighestBarCountDuringSignal(const float* signal, int signalBegin, int begin, int end, int size, float* count) {
+    int lastCount = 0;
+    HighestBarCountDuringSignalKernel kernel(lastCount);
+
+    for(int index = begin; index < end; index++) {
+        int recordedCount = 0;
+
+        count[index] = 0;
+        if(index + 1 >= size) continue;
+
+        if(kernel(signal[index - signalBegin] != 0, recordedCount)) count[index] = (float)recordedCount;
+    }
+}
+
+/* The run-length studies depend on an unbounded number of prior bars, so their chunks are computed as if no run
+ * was in progress, and then corrected here, in chunk order.
+ * Only the bars from a chunk's start until its first signal-off bar need correcting.
+ */
+void StitchRunLengths(const std::vector<float>& signal, const std::vector<int>& chunkBegins, StudyOutputs& outputs) {
+    const int size = (int)signal.size();
+
+    for(size_t chunk = 1; chunk < chunkBegins.size(); chunk++) {
+        const int begin = chunkBegins[chunk];
+        const int end = chunk + 1 < chunkBegins.size() ? chunkBegins[chunk + 1] : size;
+        const float carry = outputs.barCountDuringSignal[begin - 1];
+
+        if(carry == 0) continue;
+
+        int index = begin;
+        while(index < end && signal[index] != 0) {
+            outputs.barCountDuringSignal[index] += carry;
+            index++;
+        }
+
+        // A run spanning the whole chunk carries into the next one instead.
+        if(index < end && index + 1 < size) outputs.highestBarCountDuringSignal[index] += carry;
+    }
+}
+
+// Formats the date-time in UTC, in the layout ExportToCSV uses with FLAG_DT_COMPLETE_DATETIME.
+void FormatDateTime(int64_t dateTime, char* buffer, size_t bufferSize) {
+    const time_t seconds = (time_t)(dateTime / MICROSECONDS_PER_SECOND - SCDATETIME_UNIX_EPOCH_DAYS * 86400);
+    struct tm parts;
+
+    gmtime_r(&seconds, &parts);
+    strftime(buffer, bufferSize, "%Y-%m-%d %H:%M:%S", &parts);
+}
+
+bool WriteCsv(const char* path, const BarSeries& bars, const StudyOutputs& outputs, std::string& error) {
+    FILE* file = fopen(path, "wb");
+
+    if(file == NULL) {
+        error = std::string("unable to create ") + path + ": " + strerror(errno);
+        return false;
+    }
+
+    // A large buffer keeps the writes sequential and few.
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    fputs("\"Date Time (UTC)\",\"Bar count per duration\",\"Signal count\",\"Signal percentage\",\"Bar count during signal\",\"Highest bar count during signal\"\r\n", file);
+
+    for(size_t row = 0; row < bars.Size(); row++) {
+        char dateTime[32];
+
+        FormatDateTime(bars.startDateTime[row], dateTime, sizeof(dateTime));
+        fprintf(file, "\"%s\",\"%f\",\"%f\",\"%f\",\"%f\",\"%f\"\r\n"
+            , dateTime
+            , outputs.barCountPerDuration[row]
+            , outputs.signalCount[row]
+            , outputs.signalPercentage[row]
+            , outputs.barCountDuringSignal[row]
+            , outputs.highestBarCountDuringSignal[row]);
+    }
+
+    const bool failed = ferror(file) != 0;
+
+    if(fclose(file) != 0 || failed) {
+        error = std::string("unable to write ") + path;
+        return false;
+    }
+
+    return true;
+}
+
+// Turns /path/to/ESZ4.scid into <output directory>/ESZ4.csv.
+std::string OutputPath(const char* inputPath, const char* outputDirectory) {
+    std::string name(inputPath);
+    const size_t slash = name.find_last_of('/');
+
+    if(slash != std::string::npos) name = name.substr(slash + 1);
+    if(name.size() > 5 && name.compare(name.size() - 5, 5, ".scid") == 0) name.resize(name.size() - 5);
+
+    return std::string(outputDirectory) + "/" + name + ".csv";
+}
+
+/* The state of one symbol as it goes through the pipeline:
+ *   1. OpenFileTask maps the file and splits the records into chunks which end on bar boundaries.
+ *   2. BuildBarsTask builds the bars of one record chunk. The last one to finish joins the chunks and splits the bars.
+ *   3. StudyChunkTask computes the studies over one bar chunk. The last one to finish stitches the chunks and writes the CSV.
+ * Every chunk writes to its own slots, and the joins happen in chunk order, so the output doesn't depend on scheduling.
+ */
+struct FileJob {
+    const char* path;
+    const Options* options;
+    const SignalProgram* program;
+    MappedScidFile scid;
+    bool legacyDateTime;
+    std::vector<size_t> recordBegins;
+    std::vector<BarSeries> chunkBars;
+    BarSeries bars;
+    std::vector<int> barBegins;
+    std::vector<float> signal;
+    StudyOutputs outputs;
+    std::atomic<int> remainingChunks;
+    std::string error;
+
+    FileJob(const char* path, const Options* options, const SignalProgram* program)
+        : path(path), options(options), program(program), legacyDateTime(false), remainingChunks(0) {}
+
+    /* Frees the bars, the signal and the study outputs, once the CSV file is written,
+     * so that the memory in use doesn't grow with the number of files.
+     */
+    void ReleaseSeries() {
+        BarSeries emptyBars;
+        StudyOutputs emptyOutputs;
+
+        std::swap(bars, emptyBars);
+        std::vector<float>().swap(signal);
+        std::swap(outputs, emptyOutputs);
+    }
+};
+
+class StudyChunkTask : public SchedulerTask {
+public:
+    StudyChunkTask(FileJob& job, int chunk) : job(job), chunk(chunk) {}
+
+    void Run(WorkStealingScheduler&) {
+        const int size = (int)job.bars.Size();
+        const int begin = job.barBegins[chunk];
+        const int end = chunk + 1 < (int)job.barBegins.size() ? job.barBegins[chunk + 1] : size;
+        const int signalBegin = max(0, begin - job.options->length);
+        const BarSeries& bars = job.bars;
+        const float* operands[SIGNAL_OPERAND_COUNT] = { &bars.close[0], &bars.open[0], &bars.volume[0], &bars.numTrades[0] };
+        std::vector<float> signal(end - signalBegin);
+        StudyOutputs& outputs = job.outputs;
+
+        // The signal is evaluated again over the overlap, rather than waiting for the prior chunk.
+        EvaluateSignalBlock(*job.program, operands, signalBegin, end - signalBegin, &signal[0]);
+        std::copy(signal.begin() + (begin - signalBegin), signal.end(), job.signal.begin() + begin);
+
+        ComputeBarCountPerDuration(bars, job.options->duration, begin, end, &outputs.barCountPerDuration[0]);
+        ComputeSignalCount(&signal[0], signalBegin, job.options->length, begin, end, &outputs.signalCount[0], &outputs.signalPercentage[0]);
+        ComputeBarCountDuringSignal(&signal[0], signalBegin, begin, end, &outputs.barCountDuringSignal[0]);
+        ComputeHighestBarCountDuringSignal(&signal[0], signalBegin, begin, end, size, &outputs.highestBarCountDuringSignal[0]);
+
+        if(--job.remainingChunks > 0) return;
+
+        StitchRunLengths(job.signal, job.barBegins, outputs);
+        WriteCsv(OutputPath(job.path, job.options->outputDirectory).c_str(), bars, outputs, job.error);
+        job.ReleaseSeries();
+    }
+
+private:
+    FileJob& job;
+    int chunk;
+};
+
+class BuildBarsTask : public SchedulerTask {
+public:
+    BuildBarsTask(FileJob& job, int chunk) : job(job), chunk(chunk) {}
+
+    void Run(WorkStealingScheduler& scheduler) {
+        const size_t begin = job.recordBegins[chunk];
+        const size_t end = chunk + 1 < (int)job.recordBegins.size() ? job.recordBegins[chunk + 1] : job.scid.RecordCount();
+
+        BuildBars(job.scid.Records() + begin, end - begin, job.options->timeframe, job.legacyDateTime, job.chunkBars[chunk]);
+
+        if(--job.remainingChunks > 0) return;
+
+        JoinBars();
+
+        // The records have all been read into bars, so the file can be unmapped now, rather than when every file is done.
+        job.scid.Close();
+        SplitBars(scheduler);
+    }
+
+private:
+    FileJob& job;
+    int chunk;
+
+    void JoinBars() {
+        size_t size = 0;
+        for(size_t i = 0; i < job.chunkBars.size(); i++) size += job.chunkBars[i].Size();
+
+        BarSeries& bars = job.bars;
+        bars.startDateTime.reserve(size);
+        bars.endDateTime.reserve(size);
+        bars.open.reserve(size);
+        bars.high.reserve(size);
+        bars.low.reserve(size);
+        bars.close.reserve(size);
+        bars.volume.reserve(size);
+        bars.numTrades.reserve(size);
+
+        for(size_t i = 0; i < job.chunkBars.size(); i++) {
+            const BarSeries& part = job.chunkBars[i];
+
+            bars.startDateTime.insert(bars.startDateTime.end(), part.startDateTime.begin(), part.startDateTime.end());
+            bars.endDateTime.insert(bars.endDateTime.end(), part.endDateTime.begin(), part.endDateTime.end());
+            bars.open.insert(bars.open.end(), part.open.begin(), part.open.end());
+            bars.high.insert(bars.high.end(), part.high.begin(), part.high.end());
+            bars.low.insert(bars.low.end(), part.low.begin(), part.low.end());
+            bars.close.insert(bars.close.end(), part.close.begin(), part.close.end());
+            bars.volume.insert(bars.volume.end(), part.volume.begin(), part.volume.end());
+            bars.numTrades.insert(bars.numTrades.end(), part.numTrades.begin(), part.numTrades.end());
+        }
+
+        std::vector<BarSeries>().swap(job.chunkBars);
+    }
+
+    // Splits the bars into as many chunks as there were record chunks, but never smaller than the signal length.
+    void SplitBars(WorkStealingScheduler& scheduler) {
+        const int size = (int)job.bars.Size();
+
+        if(size == 0) {
+            job.error = "the file contains no records";
+            return;
+        }
+
+        const int chunkSize = max(job.options->length, (size + (int)job.recordBegins.size() - 1) / (int)job.recordBegins.size());
+
+        for(int begin = 0; begin < size; begin += chunkSize) job.barBegins.push_back(begin);
+
+        job.signal.assign(size, 0);
+        job.outputs.barCountPerDuration.assign(size, 0);
+        job.outputs.signalCount.assign(size, 0);
+        job.outputs.signalPercentage.assign(size, 0);
+        job.outputs.barCountDuringSignal.assign(size, 0);
+        job.outputs.highestBarCountDuringSignal.assign(size, 0);
+        job.remainingChunks = (int)job.barBegins.size();
+
+        for(size_t i = 0; i < job.barBegins.size(); i++) scheduler.Submit(new StudyChunkTask(job, (int)i));
+    }
+};
+
+class OpenFileTask : public SchedulerTask {
+public:
+    explicit OpenFileTask(FileJob& job) : job(job) {}
+
+    void Run(WorkStealingScheduler& scheduler) {
+        if(!job.scid.Open(job.path, job.error)) return;
+
+        const ScidRecord* records = job.scid.Records();
+        const size_t count = job.scid.RecordCount();
+        const size_t chunkCount = max((size_t)1, count / job.options->recordsPerChunk);
+
+        job.legacyDateTime = IsLegacyDateTime(records, count);
+        job.recordBegins.push_back(0);
+
+        // Move each split forward to where a new bar starts, so that no bar spans two chunks.
+        for(size_t chunk = 1; chunk < chunkCount; chunk++) {
+            size_t split = max(job.recordBegins.back() + 1, chunk * count / chunkCount);
+
+            while(split < count && BarKey(records[split]) == BarKey(records[split - 1])) split++;
+            if(split >= count) break;
+
+            job.recordBegins.push_back(split);
+        }
+
+        job.chunkBars.resize(job.recordBegins.size());
+        job.remainingChunks = (int)job.recordBegins.size();
+
+        for(size_t i = 0; i < job.recordBegins.size(); i++) scheduler.Submit(new BuildBarsTask(job, (int)i));
+    }
+
+private:
+    FileJob& job;
+
+    int64_t BarKey(const ScidRecord& record) const {
+        return RecordDateTime(record, job.legacyDateTime) / job.options->timeframe;
+    }
+};
+
+void PrintUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options] file.scid...\n"
+        "  -t SECONDS     Bar timeframe, aligned to midnight UTC (default 60).\n"
+        "  -d SECONDS     Bar count per duration window (default 3600).\n"
+        "  -l BARS        Signal count length (default 10).\n"
+        "  -s EXPRESSION  Signal expression, where A = close, B = open, C = volume, D = number of trades (default \"A > B\").\n"
+        "  -o DIRECTORY   Where to write the CSV files (default .).\n"
+        "  -j THREADS     Number of worker threads (default: one per core).\n"
+        "  -c RECORDS     Records per chunk, when splitting a long series (default 4194304).\n"
+        "Date-times are written in UTC.\n"
+        , program);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    SignalProgram program;
+    int threads = (int)std::thread::hardware_concurrency();
+    int option;
+    int failures = 0;
+
+    options.timeframe = 60 * MICROSECONDS_PER_SECOND;
+    options.duration = 3600;
+    options.length = 10;
+    options.signal = "A > B";
+    options.outputDirectory = ".";
+    options.recordsPerChunk = 1 << 22;
+
+    while((option = getopt(argc, argv, "t:d:l:s:o:j:c:h")) != -1) {
+        switch(option) {
+            case 't': options.timeframe = atoll(optarg) * MICROSECONDS_PER_SECOND; break;
+            case 'd': options.duration = (unsigned int)max(0, atoi(optarg)); break;
+            case 'l': options.length = atoi(optarg); break;
+            case 's': options.signal = optarg; break;
+            case 'o': options.outputDirectory = optarg; break;
+            case 'j': threads = atoi(optarg); break;
+            case 'c': options.recordsPerChunk = (size_t)atoll(optarg); break;
+            default:
+                PrintUsage(argv[0]);
+                return 2;
+        }
+    }
+
+    if(optind == argc || options.timeframe <= 0 || options.duration == 0 || options.length < 1 || options.recordsPerChunk < 1) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    if(!CompileSignalExpression(options.signal, program)) {
+        fprintf(stderr, "ERROR: Unable to compile the signal expression, at character %d.\n", program.errorPosition + 1);
+        return 2;
+    }
+
+    std::vector<FileJob*> jobs;
+
+    {
+        WorkStealingScheduler scheduler(max(1, threads));
+
+        for(int i = optind; i < argc; i++) {
+            jobs.push_back(new FileJob(argv[i], &options, &program));
+            scheduler.Submit(new OpenFileTask(*jobs.back()));
+        }
+
+        scheduler.Wait();
+    }
+
+    for(size_t i = 0; i < jobs.size(); i++) {
+        if(!jobs[i]->error.empty()) {
+            fprintf(stderr, "ERROR: %s: %s\n", jobs[i]->path, jobs[i]->error.c_str());
+            failures++;
+        }
+
+        delete jobs[i];
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/* WorkStealingScheduler.h
+
+   A small work-stealing thread pool for the batch tools.
+   Each worker owns a deque of tasks. A worker takes its newest task from the back of its own deque,
+   which keeps a task's sub-tasks on the same core while their data is still in cache,
+   and when its deque is empty it steals the oldest task from the front of another worker's deque.
+
+   Tasks may submit further tasks while running. Those land on the submitting worker's own deque.
+
+   MIT License
+
+   Copyright (c) 2025 Emmanuel Rosa
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+
+#ifndef WORK_STEALING_SCHEDULER_H
+#define WORK_STEALING_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingScheduler;
+
+class SchedulerTask {
+public:
+    virtual ~SchedulerTask() {}
+    virtual void Run(WorkStealingScheduler& scheduler) = 0;
+};
+
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(int workerCount)
+        : queues(workerCount), unfinished(0), queued(0), nextQueue(0), stopping(false) {
+        for(int i = 0; i < workerCount; i++) queues[i] = new WorkerQueue();
+        for(int i = 0; i < workerCount; i++) threads.push_back(std::thread(&WorkStealingScheduler::WorkerLoop, this, i));
+    }
+
+    ~WorkStealingScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+
+        for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+        for(size_t i = 0; i < queues.size(); i++) delete queues[i];
+    }
+
+    /* Queues the task, and takes ownership of it; the task is deleted after it runs.
+     * From a worker, the task goes on that worker's deque. Otherwise the deques are filled round-robin.
+     */
+    void Submit(SchedulerTask* task) {
+        const int worker = CurrentWorker();
+        const int index = worker >= 0 ? worker : (int)(nextQueue++ % queues.size());
+
+        unfinished++;
+
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(task);
+            queued++;
+        }
+
+        // Taking the lock, even briefly, ensures a worker can't miss the notification between checking and sleeping.
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        workAvailable.notify_one();
+    }
+
+    // Blocks until every submitted task, including those submitted by other tasks, has run.
+    void Wait() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        while(unfinished > 0) allDone.wait(lock);
+    }
+
+    int WorkerCount() const {
+        return (int)queues.size();
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<SchedulerTask*> tasks;
+    };
+
+    std::vector<WorkerQueue*> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> unfinished;
+    std::atomic<int> queued;
+    std::atomic<unsigned int> nextQueue;
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    bool stopping;
+
+    static int& CurrentWorker() {
+        static thread_local int worker = -1;
+        return worker;
+    }
+
+    bool TryTake(int self, SchedulerTask*& task) {
+        {
+            WorkerQueue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+
+            if(!own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                queued--;
+                return true;
+            }
+        }
+
+        const int count = (int)queues.size();
+
+        for(int offset = 1; offset < count; offset++) {
+            WorkerQueue& victim = *queues[(self + offset) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+
+            if(!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                queued--;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void WorkerLoop(int self) {
+        CurrentWorker() = self;
+
+        for(;;) {
+            SchedulerTask* task = NULL;
+
+            if(TryTake(self, task)) {
+                task->Run(*this);
+                delete task;
+
+                if(--unfinished == 0) {
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                    allDone.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            while(!stopping && queued == 0) workAvailable.wait(lock);
+            if(stopping && queued == 0) return;
+        }
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&);
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&);
+};
+
+#endif